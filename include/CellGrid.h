@@ -0,0 +1,86 @@
+#pragma once
+
+/*
+	Class that stores the cells of the grid in square tiles.
+	Each tile holds CELL_TILE_SIZE x CELL_TILE_SIZE cells in Z-order, so a 4x2 block
+	of cells shares a cache line and the rows above and below a cell are at most a
+	few lines away instead of a full grid row. The grid is padded by GRID_HALO
+	border cells on every side, rounded up to whole tiles.
+*/
+
+// STL
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+
+// Constants
+inline constexpr int GRID_HALO = 10;  // border cells around the grid, as wide as the longest neighbor probe
+inline constexpr int CELL_TILE_SHIFT = 3;
+inline constexpr int CELL_TILE_SIZE = 1 << CELL_TILE_SHIFT;
+inline constexpr int CELL_TILE_ORIGIN = (GRID_HALO + CELL_TILE_SIZE - 1) / CELL_TILE_SIZE * CELL_TILE_SIZE;  // storage position of cell 0, tile aligned
+
+// Z-order offsets of the low coordinate bits, x takes the even bits and y the odd ones
+inline constexpr std::array<std::uint8_t, CELL_TILE_SIZE> TILE_ORDER_X = { 0, 1, 4, 5, 16, 17, 20, 21 };
+inline constexpr std::array<std::uint8_t, CELL_TILE_SIZE> TILE_ORDER_Y = { 0, 2, 8, 10, 32, 34, 40, 42 };
+static_assert(CELL_TILE_SIZE == 8, "the Z-order tables are written for 8x8 tiles");
+
+
+// === Forward declarations ===
+class Material;
+
+
+class CellGrid
+{
+public:
+	// === Constructors ===
+	CellGrid();
+	~CellGrid();
+
+	// === Accessors ===
+	int getTileColumns() const;
+	int getTileRows() const;
+	std::unique_ptr<Material>& at(int x, int y);
+	const std::unique_ptr<Material>& at(int x, int y) const;
+
+	// === Methods ===
+	void resize(int width, int height);
+
+private:
+	std::size_t index(int x, int y) const;
+
+private:
+	int width = 0;
+	int height = 0;
+	int tilesPerRow = 0;  // storage tiles per row, border included
+	std::vector<std::unique_ptr<Material>> cells;
+};
+
+
+// === Inline access ===
+// Every neighbor probe of every cell goes through here
+
+inline std::size_t CellGrid::index(int x, int y) const
+{
+	/*
+		@return std::size_t - storage index of a cell, valid up to GRID_HALO cells outside the grid
+	*/
+
+	int storageX = x + CELL_TILE_ORIGIN;
+	int storageY = y + CELL_TILE_ORIGIN;
+	std::size_t tile = static_cast<std::size_t>(storageY >> CELL_TILE_SHIFT) * this->tilesPerRow + (storageX >> CELL_TILE_SHIFT);
+
+	return (tile << (2 * CELL_TILE_SHIFT)) | TILE_ORDER_X[storageX & (CELL_TILE_SIZE - 1)] | TILE_ORDER_Y[storageY & (CELL_TILE_SIZE - 1)];
+}
+
+inline std::unique_ptr<Material>& CellGrid::at(int x, int y)
+{
+	return this->cells[this->index(x, y)];
+}
+
+inline const std::unique_ptr<Material>& CellGrid::at(int x, int y) const
+{
+	return this->cells[this->index(x, y)];
+}
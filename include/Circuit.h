@@ -0,0 +1,98 @@
+#pragma once
+
+/*
+	Class that simulates electricity and logic on the grid.
+	Wires form networks that are kept up to date as cells are painted or erased;
+	signals propagate through worklists, so an idle circuit costs nothing per tick.
+
+	- Battery  : powers every wire network it touches
+	- Wire     : conducts instantly across its network
+	- Inverter : NOT gate, reads the cell to its left and drives the cell to its right
+	             one tick later. Inverters driving one network form a NAND.
+*/
+
+// STL
+#include <cstdint>
+#include <vector>
+
+// Project headers
+#include "MaterialEnums.h"
+
+
+enum class CircuitPart : std::uint8_t { None, Wire, Battery, Inverter };
+
+
+class Circuit
+{
+public:
+	// === Constructors ===
+	Circuit();
+
+	// === Accessors ===
+	bool isPowered(int x, int y) const;
+	bool isIdle() const;
+
+	// === Grid sync ===
+	void resize(int width, int height);
+	void setMaterial(int x, int y, MaterialType type);
+
+	// === Main logic ===
+	void update();
+
+private:
+	struct Network {
+		std::vector<int> cells;        // wire cells, in any order
+		std::vector<int> readers;      // inverters whose input cell is in this network
+		int drivers = 0;               // active sources touching the network
+		bool powered = false;
+		bool queued = false;
+		bool broken = false;           // lost a cell that may have split it
+		bool alive = false;
+	};
+
+	// === Parts ===
+	void addWire(int c);
+	void removeWire(int c);
+	void addBattery(int c);
+	void removeBattery(int c);
+	void addInverter(int c);
+	void removeInverter(int c);
+
+	// === Signals ===
+	bool readInput(int c) const;
+	void setInverterOutput(int c, bool on);
+	void scheduleGate(int c);
+	void queueNetwork(int id);
+
+	// === Networks ===
+	int createNetwork();
+	void releaseNetwork(int id);
+	void addCell(int id, int c);
+	void mergeNetwork(int from, int into);
+	void rebuildNetwork(int id);
+	void collectContacts(int id, int c);
+	void removeContacts(int id, int c);
+	int west(int c) const;
+	int east(int c) const;
+	int neighbor(int c, int side) const;
+
+private:
+	// === Grid ===
+	int width = 0;
+	int height = 0;
+	std::vector<CircuitPart> parts;
+	std::vector<int> labels;           // network of every wire cell, -1 elsewhere
+	std::vector<int> slots;            // position of every wire cell in its network's cells
+	std::vector<std::uint8_t> outputs; // inverter outputs
+	std::vector<std::uint8_t> scheduled;
+
+	// === Networks ===
+	std::vector<Network> networks;
+	std::vector<int> freeNetworks;
+
+	// === Worklists ===
+	std::vector<int> dirtyNetworks;
+	std::vector<int> brokenNetworks;
+	std::vector<int> scheduledGates;
+	std::vector<int> evaluatingGates;
+};
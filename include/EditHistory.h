@@ -0,0 +1,100 @@
+#pragma once
+
+/*
+	Class that keeps undo/redo history of brush strokes and screen clears.
+	The grid is split into chunks. A stroke saves a snapshot of each chunk the first
+	time it touches it, so its cost follows the painted area, not the grid size.
+	Snapshots are shared and copied on write: a chunk that has not changed since its
+	last snapshot reuses it, and every empty chunk points to the same snapshot.
+	Strokes are held in a memory-bounded ring, the oldest are dropped first.
+*/
+
+// STL
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <vector>
+
+// SFML
+#include <SFML/Graphics.hpp>
+
+// Project headers
+#include "MaterialEnums.h"
+
+
+// Constants
+inline constexpr int HISTORY_CHUNK_SIZE = 32;                          // cells per chunk side
+inline constexpr std::size_t HISTORY_MEMORY_LIMIT = 64 * 1024 * 1024;  // bytes of snapshots kept
+
+
+// === Forward declarations ===
+class Game;
+
+
+class EditHistory
+{
+public:
+	// === Constructors ===
+	EditHistory();
+
+	// === Accessors ===
+	bool canUndo() const;
+	bool canRedo() const;
+	std::size_t getMemoryUsage() const;
+
+	// === Grid sync ===
+	void resize(int width, int height);
+	void markChanged(int x, int y);
+	void markColumnChanged(int x, int top, int bottom);
+
+	// === Strokes ===
+	bool isStroking() const;
+	void beginStroke();
+	void touchArea(Game& game, int left, int top, int right, int bottom);
+	void endStroke();
+
+	// === Main logic ===
+	bool undo(Game& game);
+	bool redo(Game& game);
+
+private:
+	struct ChunkSnapshot {
+		std::array<MaterialType, HISTORY_CHUNK_SIZE * HISTORY_CHUNK_SIZE> types;
+		std::array<sf::Color, HISTORY_CHUNK_SIZE * HISTORY_CHUNK_SIZE> colors;
+	};
+
+	struct ChunkEdit {
+		int chunk;
+		std::shared_ptr<const ChunkSnapshot> snapshot;
+	};
+
+	struct Stroke {
+		std::vector<ChunkEdit> chunks;
+		std::size_t bytes = 0;
+	};
+
+	std::shared_ptr<const ChunkSnapshot> capture(Game& game, int chunk);
+	void restore(Game& game, Stroke& stroke);
+	std::size_t countBytes(const Stroke& stroke) const;
+	void trimMemory();
+
+private:
+	int width = 0;
+	int height = 0;
+	int chunkColumns = 0;
+	int chunkRows = 0;
+
+	std::shared_ptr<const ChunkSnapshot> emptySnapshot;
+	std::vector<std::shared_ptr<const ChunkSnapshot>> snapshots;  // last snapshot of every chunk
+	std::vector<std::uint8_t> changed;                            // 1 if the chunk changed since its snapshot
+	std::vector<std::uint8_t> touched;                            // 1 if the current stroke saved the chunk
+
+	Stroke stroke;
+	bool stroking = false;
+
+	std::deque<Stroke> undoStrokes;
+	std::deque<Stroke> redoStrokes;
+	std::size_t memoryUsage = 0;
+};
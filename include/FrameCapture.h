@@ -0,0 +1,70 @@
+#pragma once
+
+/*
+	Class that saves simulation frames as a PNG sequence.
+	Frames are copied into a small set of reusable RGBA buffers and encoded by
+	background threads, so the simulation only pays for the copy. When every
+	buffer is waiting for the encoder a frame is dropped instead of blocking,
+	unless the caller asks to wait.
+*/
+
+// STL
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Project headers
+#include "ThreadPool.h"
+
+
+// Constants
+inline constexpr std::size_t CAPTURE_QUEUE_LIMIT = 8;  // frames waiting for the encoder at most
+inline constexpr unsigned CAPTURE_ENCODER_THREADS = 2;
+
+
+class FrameCapture
+{
+public:
+	// === Constructors ===
+	explicit FrameCapture(const std::string& directory,
+		unsigned encoderThreads = CAPTURE_ENCODER_THREADS, std::size_t queueLimit = CAPTURE_QUEUE_LIMIT);
+	~FrameCapture();
+
+	// === Accessors ===
+	bool isReady() const;
+	const std::string& getError() const;
+	std::size_t getSavedCount() const;
+	std::size_t getDroppedCount() const;
+	std::size_t getFailedCount() const;
+
+	// === Methods ===
+	std::vector<std::uint8_t>* acquire(bool wait = false);
+	void submit(std::vector<std::uint8_t>* buffer, int frame, unsigned width, unsigned height);
+	void flush();
+
+private:
+	void encode(std::vector<std::uint8_t>* buffer, int frame, unsigned width, unsigned height);
+
+private:
+	std::string directory;
+	std::size_t queueLimit;
+	std::string error;  // why the directory could not be created, empty = ready
+
+	// === Buffers ===
+	std::vector<std::unique_ptr<std::vector<std::uint8_t>>> buffers;
+	std::vector<std::vector<std::uint8_t>*> freeBuffers;
+	std::size_t inFlight = 0;
+	mutable std::mutex mutex;
+	std::condition_variable bufferReturned;
+
+	// === Stats ===
+	std::size_t saved = 0;
+	std::size_t dropped = 0;
+	std::size_t failed = 0;
+
+	// Declared last so its workers stop before the buffers go away
+	ThreadPool encoders;
+};
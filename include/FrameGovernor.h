@@ -0,0 +1,58 @@
+#pragma once
+
+/*
+	Class that keeps the frame time within its budget by lowering simulation quality.
+	Measures the work of every frame, simulation and drawing without the frame limit
+	sleep, and keeps a moving average. Under pressure it steps the quality down one
+	level at a time, each level adding to the ones before:
+		1 - gases move on alternating ticks, the gas field steps every other tick
+		2 - liquids flow at most GOVERNOR_LIQUID_DISPERSION cells sideways
+		3 - tiles away from the brush are updated every other tick
+	Once the average stays well under the budget the levels are restored one by one.
+*/
+
+// SFML
+#include <SFML/System.hpp>
+
+
+// Constants
+inline constexpr int GOVERNOR_MAX_LEVEL = 3;
+inline constexpr float GOVERNOR_SMOOTHING = 0.1f;      // weight of the newest frame in the average
+inline constexpr float GOVERNOR_PRESSURE = 0.9f;       // share of the budget above which quality drops
+inline constexpr float GOVERNOR_HEADROOM = 0.5f;       // share of the budget below which quality returns
+inline constexpr int GOVERNOR_SETTLE_FRAMES = 30;      // frames after a change before the average is trusted again
+inline constexpr int GOVERNOR_RESTORE_FRAMES = 120;    // frames of headroom before a level is restored
+inline constexpr int GOVERNOR_LIQUID_DISPERSION = 4;   // sideways flow of liquids from level 2, cells per tick
+inline constexpr int GOVERNOR_FOCUS_RADIUS = 64;       // cells around the brush that keep the full tick rate at level 3
+
+
+class FrameGovernor
+{
+public:
+	// === Constructors ===
+	FrameGovernor();
+
+	// === Accessors ===
+	int getLevel() const;
+	const char* getLevelName() const;
+	float getAverageWork() const;
+	bool throttlesGas() const;
+	bool limitsDispersion() const;
+	bool halvesDistantTiles() const;
+
+	// === Methods ===
+	void beginFrame(float budget);
+	void beginWork();
+	void endWork();
+
+private:
+	sf::Clock clock;
+	bool measuring = false;
+	bool hasFrame = false;
+	float frameWork = 0.0f;    // seconds measured in the current frame
+	float averageWork = 0.0f;  // seconds per frame
+
+	int level = 0;
+	int settleFrames = 0;
+	int headroomFrames = 0;
+};
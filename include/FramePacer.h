@@ -0,0 +1,69 @@
+#pragma once
+
+/*
+	Class that paces frames to a target rate with a hybrid sleep and spin wait.
+	The window frame limit sleeps with the granularity of the OS timer, so frames
+	arrive unevenly and input waits in the queue while the game sleeps after drawing.
+	The pacer predicts the cost of the next frame from recent ones and waits until
+	the latest start that still finishes on time, so input is read right before the
+	frame that shows it. A frame that finishes early is held back to its deadline,
+	so frames are presented at an even rate whatever they cost. Sleeps are only
+	trusted as far as they have been measured to overshoot; the rest of a wait spins.
+*/
+
+// STL
+#include <chrono>
+
+
+// Constants
+inline constexpr int PACER_DEFAULT_RATE = 120;
+inline constexpr float PACER_SMOOTHING = 0.125f;          // weight of the newest sample in an average
+inline constexpr float PACER_DEVIATION_SMOOTHING = 0.25f; // weight of the newest sample in a deviation
+inline constexpr float PACER_COST_MARGIN = 4.0f;          // deviations of frame cost allowed for
+inline constexpr float PACER_SLEEP_MARGIN = 2.0f;         // deviations of sleep overshoot allowed for
+inline constexpr float PACER_SAFETY = 0.0005f;            // seconds kept between the predicted end of a frame and its deadline
+
+
+class FramePacer
+{
+public:
+	// === Constructors ===
+	explicit FramePacer(int rate = PACER_DEFAULT_RATE);
+	~FramePacer();
+
+	FramePacer(const FramePacer&) = delete;
+	FramePacer& operator=(const FramePacer&) = delete;
+
+	// === Accessors ===
+	int getTargetRate() const;
+	void setTargetRate(int rate);
+	float getFramePeriod() const;
+	float getPredictedCost() const;
+	float getJitter() const;
+
+	// === Methods ===
+	void waitForFrame();
+	void waitForPresent();
+	void framePresented();
+
+private:
+	using Clock = std::chrono::steady_clock;
+
+	void sleepUntil(Clock::time_point time);
+
+private:
+	int rate = PACER_DEFAULT_RATE;
+	Clock::duration period;
+	Clock::time_point deadline;     // when the next frame should be presented
+	Clock::time_point frameStart;   // end of the last wait
+	Clock::time_point lastPresent;
+	bool started = false;
+	bool waited = false;            // the current frame started from waitForFrame, its cost is known
+
+	// Seconds, averages with their mean deviation
+	float costAverage = 0.0f;
+	float costDeviation = 0.0f;
+	float sleepAverage = 0.002f;    // a 1 ms sleep, until measured
+	float sleepDeviation = 0.001f;
+	float jitter = 0.0f;            // mean deviation of the present interval from the period
+};
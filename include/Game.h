@@ -6,6 +6,7 @@
 */
 
 // STL
+#include <cstdint>
 #include <random>
 #include <vector>
 
@@ -13,14 +14,36 @@
 #include <SFML/Graphics.hpp>
 
 // Project headers
+#include "CellGrid.h"
+#include "Circuit.h"
+#include "EditHistory.h"
+#include "FrameGovernor.h"
+#include "FramePacer.h"
+#include "GasField.h"
+#include "GrowthSystem.h"
+#include "HeatField.h"
+#include "InputSampler.h"
+#include "MargolusEngine.h"
+#include "MaterialCensus.h"
 #include "MaterialEnums.h"
+#include "Minimap.h"
+#include "OccupancyMap.h"
+#include "PerfCounters.h"
+#include "ReactionEngine.h"
+#include "ReplayPlayer.h"
+#include "ReplayRecorder.h"
+#include "RewindBuffer.h"
+#include "RigidBodies.h"
+#include "ThreadPool.h"
 #include "UIScaler.h"
+#include "WindField.h"
 
 
 // === ENUMS & STRUCTS ===
 enum class WindowMode { Stretch, Fit };
 enum class BrushActionType { SPAWN, CLEAR, DRAW };
 enum class BrushShape { CIRCLE, SQUARE, TRIANGLE };
+enum class EngineMode { Classic, Margolus };  // per-cell material rules or 2x2 block automaton
 
 struct Screen {
 	struct R11x9 { // 1.22
@@ -111,7 +134,7 @@ class Game
 {
 public:
 	// === Constructors ===
-	Game();
+	explicit Game(bool headless = false);
 	virtual ~Game();
 
 	// === Accessors ===
@@ -119,29 +142,62 @@ public:
 	sf::Vector2u getWindowSize() const;
 	bool hasGameBorders() const;
 	std::mt19937& getRandom();
+	sf::Vector2f getWindVelocity(int x, int y) const;
+	MaterialCensus& getCensus();
+	PerfCounters& getPerfCounters();
+	const OccupancyMap& getOccupancy() const;
+	int getDispersionLimit() const;
+	bool skipsGasUpdate(int x, int y) const;
+	EngineMode getEngineMode() const;
+	void setEngineMode(EngineMode mode);
+	void setSeed(std::uint32_t seed);
 
 	// === Grid helpers ===
 	bool isValidPosition(int x, int y) const;
 	bool isEmpty(int x, int y) const;
 	MaterialType getMaterialType(int x, int y) const;
 	Material* getRawMaterial(int x, int y);
+	Material* getNeighbor(int x, int y) const;
 	void setMaterialAt(MaterialType material, int x, int y);
+	void setColorAt(int x, int y, sf::Color color);
 	void swapMaterials(int x1, int y1, int x2, int y2);
+	void shiftColumnDown(int x, int top, int bottom);
 
 	// === Main logic ===
 	void update();
 	void render();
+	void copyFrame(std::vector<std::uint8_t>& pixels) const;
+	void packCells(std::vector<std::uint32_t>& cells) const;
+	void packChunks(RewindFrame& frame) const;
+	void restoreState(const std::vector<std::uint32_t>& cells);
+
+	// === Replays ===
+	bool loadReplay(const std::string& path);
 
 private:
 	// === Init Methods ===
 	std::unique_ptr<sf::RenderWindow> initWindow();
 	void initVertexGrid();
+	void fillBorder();
+
+	// === Grid storage ===
+	std::unique_ptr<Material>& cell(int x, int y);
+	const std::unique_ptr<Material>& cell(int x, int y) const;
 
 	// === Update Methods ===
-	void handleEvents();
+	bool handleEvents();
+	bool isSimulationIdle() const;
+	bool tryColumnFall(int x, int y);
+	void updateHeat();
+	void updateReplay();
+	void handleReplayKey(sf::Keyboard::Key key);
+	void toggleRecording();
+	void toggleTracing();
+	void scrubRewind(int ticks);
 	void updateVertexColors();
 	void updateFPS();
 	void updateSelectedMaterialText();
+	void setGasMode(bool enabled);
 
 	// === View Management ===
 	void updateView(WindowMode mode);
@@ -153,11 +209,17 @@ private:
 	void drawPen();
 
 	// === Interaction ===
-	void spawnMaterial();
+	void paintSample(const InputSample& sample);
+	void stampStroke();
+	void spawnMaterial(const std::vector<sf::Vector2i>& path);
 	std::unique_ptr<Material> createMaterial(MaterialType type, int x, int y);
-	void clearArea();
+	void clearArea(const std::vector<sf::Vector2i>& path);
+	void saveBrushArea(const std::vector<sf::Vector2i>& path);
 	template <typename Func>
 	void forEachInBrush(const sf::Vector2i& mousePos, Func func, BrushActionType action);
+	template <typename Func>
+	void forEachInStroke(const std::vector<sf::Vector2i>& path, Func func);
+	bool getBrushSpan(int dy, int& left, int& right) const;
 	sf::Vector2i getMousePosition();
 
 	// === GUI ===
@@ -179,11 +241,49 @@ private:
 	bool isPaused;
 	bool hasBorders;
 	bool showFps;
+	bool gasMode = false;
+	bool idle = false;  // the last frame changed nothing, the next one waits for an event
 	sf::Image icon;
 
 	// === Grid ===
-	std::vector<std::vector<std::unique_ptr<Material>>> grid;
+	CellGrid grid;  // tiled, padded by GRID_HALO border cells on every side
+	OccupancyMap occupancy;
 	sf::VertexArray vertexGrid;
+	Minimap minimap;
+	int tick = 0;
+	bool gridChanged = false;  // set by the grid hooks, cleared every frame
+	EngineMode engineMode = EngineMode::Classic;
+	MargolusEngine margolus;
+
+	// === Simulation fields ===
+	ThreadPool threadPool;
+	HeatField heatField;
+	ReactionEngine reactions;
+	WindField windField;
+	GasField gasField;
+	Circuit circuit;
+	GrowthSystem growth;
+	RigidBodies rigidBodies;
+	MaterialCensus census;
+
+	// === Profiling ===
+	PerfCounters perfCounters;
+	FrameGovernor governor;  // windowed games only, headless runs keep full quality
+
+	// === Undo/redo ===
+	EditHistory history;
+
+	// === Replays ===
+	ReplayRecorder recorder;
+	std::vector<std::uint32_t> recordedCells;
+	std::unique_ptr<ReplayPlayer> replayPlayer;
+	int replaySpeed = 1;
+	bool replayPaused = false;
+
+	// === Rewind ===
+	RewindBuffer rewind;
+	std::vector<std::uint32_t> rewindCells;
+	int rewindTick = -1;  // tick shown in the grid, behind the buffer's last tick while scrubbing
 
 	// === Brush ===
 	MaterialType currentMaterial;
@@ -191,6 +291,13 @@ private:
 	float brushSolidity;
 	BrushShape brushShape;
 
+	// === Strokes ===
+	InputSampler inputSampler;
+	std::vector<InputSample> inputSamples;
+	std::vector<sf::Vector2i> strokePath;  // cells passed since the last stamp, the first one was stamped already
+	std::int64_t lastStampTime = 0;
+	bool strokeErases = false;
+
 	// === Random ===
 	std::random_device rd;
 	std::mt19937 gen;
@@ -200,6 +307,7 @@ private:
 	int frameCount = 0;
 	int maxFps = 120;
 	float fps = 0.f;
+	FramePacer pacer;
 
 	// === Text UI ===
 	sf::Font defaultFont;
@@ -212,4 +320,30 @@ private:
 	sf::Text messageText;
 	bool showMessage = false;
 	float messageDuration = 2.0f;
-};
\ No newline at end of file
+};
+
+
+// === Inline grid access ===
+// Defined here so the material rules inline them, they run for every probe of every cell
+
+inline Material* Game::getNeighbor(int x, int y) const
+{
+	/*
+		@return Material* - cell or border sentinel, never nullptr
+
+		Unchecked. Valid for positions up to GRID_HALO cells outside the grid, where
+		the border holds Wall or Void sentinels depending on the border mode.
+	*/
+
+	return this->grid.at(x, y).get();
+}
+
+inline std::unique_ptr<Material>& Game::cell(int x, int y)
+{
+	return this->grid.at(x, y);
+}
+
+inline const std::unique_ptr<Material>& Game::cell(int x, int y) const
+{
+	return this->grid.at(x, y);
+}
\ No newline at end of file
@@ -0,0 +1,60 @@
+#pragma once
+
+/*
+	Class that represents gases as a concentration per grid cell.
+	Used by the gas field mode instead of discrete smoke cells: the field
+	diffuses, rises and decays at a fixed cost per tick.
+*/
+
+// STL
+#include <vector>
+
+// Project headers
+#include "ThreadPool.h"
+
+
+// Constants
+inline constexpr float GAS_DIFFUSION = 0.15f;   // share exchanged with each side neighbour per tick
+inline constexpr float GAS_RISE = 0.3f;         // share moved one cell up per tick
+inline constexpr float GAS_DECAY = 0.997f;      // share kept per tick
+inline constexpr float GAS_IDLE_DENSITY = 0.002f; // thinner gas rounds to the plain cell color in the overlay
+
+
+class GasField
+{
+public:
+	// === Constructors ===
+	GasField();
+
+	// === Accessors ===
+	float getDensity(int x, int y) const;
+	bool isIdle() const;
+	void add(int x, int y, float amount);
+	void clear();
+
+	// === Grid sync ===
+	void resize(int width, int height);
+	void setOpen(int x, int y, bool open);
+	void swapCells(int x1, int y1, int x2, int y2);
+
+	// === Main logic ===
+	void step(ThreadPool& pool);
+
+private:
+	int index(int x, int y) const;
+
+private:
+	// === Field size (padded by one cell on every side) ===
+	int width = 0;
+	int height = 0;
+	int stride = 0;
+
+	// === Per-cell data ===
+	std::vector<float> density;
+	std::vector<float> nextDensity;
+	std::vector<float> open;           // 1 where gas can spread (empty cells), 0 elsewhere and in the halo
+
+	// === Peak density, the field is idle once no cell is visible ===
+	std::vector<float> rowPeaks;
+	float peak = 0.0f;
+};
@@ -0,0 +1,64 @@
+#pragma once
+
+/*
+	Class that grows biological materials.
+	Keeps a sparse set of growth fronts (living cells next to something they can grow into)
+	and draws a batch of random growth attempts from it every tick, so the cost follows
+	the perimeter of living regions rather than their area.
+*/
+
+// STL
+#include <cstdint>
+#include <vector>
+
+// Project headers
+#include "MaterialEnums.h"
+
+
+// Constants
+inline constexpr float GROWTH_ATTEMPT_SHARE = 0.05f; // share of the fronts tried per tick
+inline constexpr int GROWTH_MIN_ATTEMPTS = 4;         // attempts per tick for small plants
+inline constexpr std::uint32_t GROWTH_CHANCE = 0x80000000u; // chance of an attempt to succeed, out of 2^32
+
+
+// === Forward declarations ===
+class Game;
+
+
+class GrowthSystem
+{
+public:
+	// === Constructors ===
+	GrowthSystem();
+
+	// === Accessors ===
+	std::size_t getFrontCount() const;
+	bool isIdle() const;
+
+	// === Grid sync ===
+	void resize(int width, int height);
+	void setMaterial(int x, int y, MaterialType type);
+	void moveMaterial(int x, int y, MaterialType type);
+
+	// === Main logic ===
+	void update(Game& game);
+
+private:
+	static bool canGrowInto(MaterialType type);
+
+	void addFront(int c);
+	void removeFront(int c);
+	void wakeNeighbors(int c);
+	bool hasRoomToGrow(Game& game, int c) const;
+	int neighbor(int c, int side) const;
+
+private:
+	int width = 0;
+	int height = 0;
+
+	std::vector<std::uint8_t> plants;  // 1 for living cells
+	std::size_t plantCount = 0;
+
+	std::vector<int> fronts;
+	std::vector<int> frontSlots;       // position of each cell in fronts, -1 when not a front
+};
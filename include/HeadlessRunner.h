@@ -0,0 +1,58 @@
+#pragma once
+
+/*
+	Class that runs the simulation without a window.
+	Plays a scripted scenario for a fixed number of ticks and can save every Nth
+	frame as a PNG, for visual regression checks and offline videos.
+
+	SimpleBox --headless [--ticks N] [--grid WxH] [--scenario NAME]
+	          [--capture DIR] [--capture-every N] [--capture-wait] [--record FILE]
+	          [--trace FILE] [--perf] [--perf-ticks FILE] [--engine classic|margolus] [--seed N]
+*/
+
+// STL
+#include <cstdint>
+#include <string>
+
+
+// === Forward declarations ===
+class Game;
+class PerfCounters;
+
+
+struct HeadlessOptions {
+	int ticks = 600;
+	int gridWidth = 0;             // 0 keeps the default grid size
+	int gridHeight = 0;
+	std::string scenario = "sandfall";
+	std::string captureDirectory;  // empty = no capture
+	int captureEvery = 1;
+	bool captureWait = false;      // block on a full encoder queue instead of dropping frames
+	std::string recordPath;        // empty = no replay
+	std::string tracePath;         // empty = no timeline trace
+	bool perf = false;             // report hardware counters (Linux)
+	std::string perfTicksPath;     // empty = no per-tick counter CSV
+	bool margolus = false;         // run the block automaton instead of the material rules
+	bool hasSeed = false;          // without a seed every run is different
+	std::uint32_t seed = 0;
+};
+
+
+class HeadlessRunner
+{
+public:
+	// === Constructors ===
+	explicit HeadlessRunner(const HeadlessOptions& options);
+
+	// === Main logic ===
+	static bool isRequested(int argc, char* argv[]);
+	static bool parseArguments(int argc, char* argv[], HeadlessOptions& options);
+	int run();
+
+private:
+	bool applyScenario(Game& game, int tick) const;
+	void reportCounters(const PerfCounters& counters) const;
+
+private:
+	HeadlessOptions options;
+};
@@ -0,0 +1,73 @@
+#pragma once
+
+/*
+	Class that represents the temperature of every grid cell.
+	Dense field stored next to the grid and diffused at a lower rate than movement.
+*/
+
+// STL
+#include <cstdint>
+#include <vector>
+
+// Project headers
+#include "MaterialTable.h"
+#include "ThreadPool.h"
+
+
+// Constants
+inline constexpr int HEAT_UPDATE_INTERVAL = 4; // movement ticks per heat tick
+inline constexpr float HEAT_SETTLED_CHANGE = 0.001f; // largest change per heat tick of a field at rest, degrees
+
+
+class HeatField
+{
+public:
+	// === Constructors ===
+	HeatField();
+
+	// === Accessors ===
+	float getTemperature(int x, int y) const;
+	void setTemperature(int x, int y, float temperature);
+	bool isIdle() const;
+
+	// === Grid sync ===
+	void resize(int width, int height);
+	void setMaterial(int x, int y, MaterialType type);
+	void swapCells(int x1, int y1, int x2, int y2);
+	void shiftColumnDown(int x, int top, int bottom);
+
+	// === Main logic ===
+	const std::vector<int>& step(ThreadPool& pool);
+
+private:
+	int index(int x, int y) const;
+
+private:
+	// === Field size (padded by one cell on every side) ===
+	int width = 0;
+	int height = 0;
+	int stride = 0;
+
+	// === Per-cell data ===
+	std::vector<std::uint8_t> materials;
+	std::vector<float> temperature;
+	std::vector<float> nextTemperature;
+	std::vector<float> conductivity;
+	std::vector<float> rate;
+	std::vector<float> exchange;
+
+	// === Per-material coefficients ===
+	std::vector<float> materialConductivity;
+	std::vector<float> materialRate;
+	std::vector<float> materialExchange;
+	std::vector<float> lowTemperature;
+	std::vector<float> highTemperature;
+
+	// === Phase transitions found by the last step ===
+	std::vector<std::vector<int>> rowTransitions;
+	std::vector<int> transitions;
+
+	// === Rest detection ===
+	std::vector<float> rowChanges;     // largest change of every row in the last step
+	bool settled = true;               // the last step changed nothing visible and no cell was touched since
+};
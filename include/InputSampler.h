@@ -0,0 +1,76 @@
+#pragma once
+
+/*
+	Class that samples the mouse on its own thread while a button is held.
+	The frame loop only sees the mouse once per frame, so fast drags skip cells
+	and a slow frame delays the brush. While painting, this thread polls the
+	position and buttons at INPUT_SAMPLE_RATE and queues timestamped samples;
+	the game drains them every frame and paints the stroke between them.
+	Between strokes the thread sleeps until the next button press.
+	SFML only supports reading the mouse off the main thread on Windows. Elsewhere
+	no thread is started and poll() takes one sample per frame on the main thread.
+*/
+
+// STL
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// SFML
+#include <SFML/Window.hpp>
+
+
+// Constants
+inline constexpr int INPUT_SAMPLE_RATE = 1000;          // mouse polls per second while a button is held
+inline constexpr std::size_t INPUT_QUEUE_LIMIT = 4096;  // samples kept while the frame loop stalls, the oldest are dropped
+
+
+// === ENUMS & STRUCTS ===
+struct InputSample {
+	sf::Vector2i position;  // window pixels
+	bool left = false;
+	bool right = false;
+	std::int64_t time = 0;  // microseconds on the steady clock
+};
+
+
+class InputSampler
+{
+public:
+	// === Constructors ===
+	InputSampler();
+	~InputSampler();
+
+	InputSampler(const InputSampler&) = delete;
+	InputSampler& operator=(const InputSampler&) = delete;
+
+	// === Accessors ===
+	static std::int64_t now();
+
+	// === Methods ===
+	void start(const sf::Window& window);
+	void stop();
+	void press(const sf::Vector2i& position, sf::Mouse::Button button);
+	void poll();
+	void drain(std::vector<InputSample>& samples);
+
+private:
+	void sampleLoop();
+	InputSample takeSample() const;
+	void record(const InputSample& sample);
+	void push(const InputSample& sample);
+
+private:
+	const sf::Window* window = nullptr;
+	std::thread thread;
+
+	std::mutex mutex;
+	std::condition_variable pressed;
+	std::deque<InputSample> queue;
+	bool sampling = false;  // a button is down, the thread polls
+	std::int64_t pressTime = 0;
+	bool stopping = false;
+};
@@ -0,0 +1,61 @@
+#pragma once
+
+/*
+	Class that moves materials as a block cellular automaton.
+	The grid is split into 2x2 Margolus blocks, shifted by one cell every other
+	tick. Every cell is reduced to a movement class and the next state of a block
+	is a permutation of its four cells, looked up in a table indexed by their
+	classes. Blocks of a phase do not overlap, so the lookups run in parallel; the
+	moves are then applied through the grid hooks. A seeded hash of the block and
+	tick picks between the table and its mirror image, so runs are reproducible.
+*/
+
+// STL
+#include <array>
+#include <cstdint>
+#include <vector>
+
+// Project headers
+#include "MaterialEnums.h"
+
+
+// Constants
+inline constexpr int MARGOLUS_CLASS_BITS = 3;
+inline constexpr std::size_t MARGOLUS_TABLE_SIZE = std::size_t(1) << (4 * MARGOLUS_CLASS_BITS);
+inline constexpr std::uint8_t MARGOLUS_IDENTITY = 0b11100100;  // every cell takes its own content
+
+
+// === ENUMS & STRUCTS ===
+enum class BlockClass : std::uint8_t { Empty, Static, Powder, Liquid, Gas };
+
+
+// === Forward declarations ===
+class Game;
+class ThreadPool;
+
+
+class MargolusEngine
+{
+public:
+	// === Constructors ===
+	MargolusEngine();
+
+	// === Accessors ===
+	static BlockClass classify(MaterialType type);
+
+	// === Methods ===
+	void setSeed(std::uint32_t seed);
+	void step(Game& game, ThreadPool& pool, int tick);
+
+private:
+	void buildTable();
+	static std::uint8_t resolve(const std::array<BlockClass, 4>& classes);
+	std::uint32_t hash(int blockX, int blockY, int tick) const;
+
+private:
+	// Permutation per class index: two bits per cell give the cell its content comes from,
+	// the second half holds the mirrored rules
+	std::vector<std::uint8_t> table;
+	std::vector<std::uint8_t> moves;  // permutation of every block in the current phase
+	std::uint32_t seed = 0;
+};
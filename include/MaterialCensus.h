@@ -0,0 +1,68 @@
+#pragma once
+
+/*
+	Class that counts materials without scanning the grid.
+	Keeps a count per material and a material histogram per chunk, both updated by
+	the grid hooks on every placement and on every move across a chunk border.
+	Region queries add up the histograms of the chunks they cover and answer the
+	partly covered chunks from a summed-area table, built on demand per chunk and
+	kept until the chunk changes.
+*/
+
+// STL
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Project headers
+#include "MaterialEnums.h"
+
+
+// Constants
+inline constexpr int CENSUS_CHUNK_SIZE = 32;  // cells per chunk side
+
+
+// === Forward declarations ===
+class Game;
+
+
+class MaterialCensus
+{
+public:
+	// === Constructors ===
+	MaterialCensus();
+
+	// === Accessors ===
+	std::size_t getCount(MaterialType type) const;
+	std::size_t getCountByIndex(std::size_t index) const;
+
+	// === Grid sync ===
+	void resize(int width, int height);
+	void setMaterial(int x, int y, MaterialType previous, MaterialType material);
+	void swapCells(int x1, int y1, int x2, int y2, MaterialType type1, MaterialType type2);
+	void shiftColumnDown(const Game& game, int x, int top, int bottom);
+
+	// === Queries ===
+	std::size_t countInRegion(const Game& game, MaterialType type, int left, int top, int right, int bottom);
+
+private:
+	struct ChunkTable {
+		int material = -1;               // material index the sums were built for, -1 = stale
+		std::vector<std::uint16_t> sums;  // (CENSUS_CHUNK_SIZE + 1)^2 summed-area table
+	};
+
+	int chunkAt(int x, int y) const;
+	std::uint16_t& histogram(int chunk, std::size_t material);
+	const ChunkTable& buildTable(const Game& game, int chunk, std::size_t material);
+
+private:
+	int width = 0;
+	int height = 0;
+	int chunkColumns = 0;
+	int chunkRows = 0;
+	std::size_t materialCount = 0;
+
+	std::vector<std::size_t> counts;        // cells per material index
+	std::vector<std::uint16_t> histograms;  // chunk-major, materialCount entries per chunk
+	std::vector<ChunkTable> tables;
+};
@@ -25,13 +25,25 @@ enum class MaterialType : uint16_t {
 	Empty = static_cast<uint16_t>(MaterialState::SolidUnmovable) | 0b000000000000001,
 	Stone = static_cast<uint16_t>(MaterialState::SolidUnmovable) | 0b000000000000010,
 	Brick = static_cast<uint16_t>(MaterialState::SolidUnmovable) | 0b000000000000011,
+	Vent = static_cast<uint16_t>(MaterialState::SolidUnmovable)  | 0b000000000000110,
+	Wire = static_cast<uint16_t>(MaterialState::SolidUnmovable)  | 0b000000000000111,
+	Battery = static_cast<uint16_t>(MaterialState::SolidUnmovable)  | 0b000000000001000,
+	Inverter = static_cast<uint16_t>(MaterialState::SolidUnmovable) | 0b000000000001001,
+	Plant = static_cast<uint16_t>(MaterialState::SolidUnmovable)    | 0b000000000001010,
 	Sand = static_cast<uint16_t>(MaterialState::SolidMovable)    | 0b000000000000100,
 	Dirt = static_cast<uint16_t>(MaterialState::SolidMovable)    | 0b000000000000101,
 
 	// LIQUID
 	Water = static_cast<uint16_t>(MaterialState::Liquid) | 0b000000000000001,
 	Oil = static_cast<uint16_t>(MaterialState::Liquid)   | 0b000000000000010,
+	Lava = static_cast<uint16_t>(MaterialState::Liquid)  | 0b000000000000011,
 
 	// GAS
-	Smoke = static_cast<uint16_t>(MaterialState::Gaseous) | 0b000000000000001
+	Smoke = static_cast<uint16_t>(MaterialState::Gaseous) | 0b000000000000001,
+	Steam = static_cast<uint16_t>(MaterialState::Gaseous) | 0b000000000000010,
+	Fire = static_cast<uint16_t>(MaterialState::Gaseous)  | 0b000000000000011,
+
+	// BORDER (sentinels around the grid, never placed in it)
+	Wall = static_cast<uint16_t>(MaterialState::None) | 0b000000000000001,
+	Void = static_cast<uint16_t>(MaterialState::None) | 0b000000000000010
 };
\ No newline at end of file
@@ -0,0 +1,97 @@
+#pragma once
+
+/*
+	Dense per-material property table.
+	Indexed by materialIndex() so that field simulations can read it without branching.
+	Built-in materials fill the first rows, materials from the definitions file
+	(resources/materials.txt) are compiled into the rows after them at startup.
+*/
+
+// STL
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+// Project headers
+#include "MaterialEnums.h"
+
+
+// === Material index ===
+constexpr std::size_t MAX_MATERIAL_COUNT = 256;       // indices are stored as uint8_t
+constexpr std::size_t MATERIAL_TYPE_SPACE = 1 << 15;  // every MaterialType value fits below it
+constexpr uint16_t DEFINED_INDEX_BASE = 0b10000000000; // index bits of loaded materials start here
+
+// MaterialType value -> row of the table, unknown types map to Empty (0)
+extern std::array<std::uint8_t, MATERIAL_TYPE_SPACE> materialIndices;
+
+inline std::size_t materialIndex(MaterialType type)
+{
+	return materialIndices[static_cast<uint16_t>(type) & (MATERIAL_TYPE_SPACE - 1)];
+}
+
+
+// === Properties ===
+inline constexpr float AMBIENT_TEMPERATURE = 20.0f;
+inline constexpr float NO_TRANSITION_LOW = -std::numeric_limits<float>::infinity();
+inline constexpr float NO_TRANSITION_HIGH = std::numeric_limits<float>::infinity();
+
+struct ThermalProperties {
+	float conductivity;      // 0..1, share of a temperature difference passed to a neighbour per heat tick
+	float heatCapacity;      // >= 1, water = 4
+	float ambientExchange;   // 0..1, share of the difference to AMBIENT_TEMPERATURE lost per heat tick
+	float spawnTemperature;  // degrees Celsius
+};
+
+struct PhaseTransition {
+	float lowTemperature;    // below it the cell turns into lowProduct
+	MaterialType lowProduct;
+	float highTemperature;   // above it the cell turns into highProduct
+	MaterialType highProduct;
+};
+
+struct MaterialInfo {
+	MaterialType type;
+	std::string name;
+	ThermalProperties thermal;
+	PhaseTransition phase;
+	float flammability;      // 0..1, chance per reaction tick to catch fire from a burning neighbour
+};
+
+struct ReactionRule {
+	MaterialType self;
+	MaterialType neighbor;
+	MaterialType selfProduct;
+	MaterialType neighborProduct;
+	float chance;            // 0..1 per reaction tick
+};
+
+// Letters with a command in Game::handleEvents, a definition key on them would never be dispatched
+inline constexpr const char* RESERVED_MATERIAL_KEYS = "BCEFGLMNPRVW";
+
+// Everything the generic material classes need to build a cell of a loaded material
+struct MaterialDefinition {
+	MaterialType type;
+	std::string name;
+	float density;                    // kg / m^3
+	float dispersion;                 // liquids: cells sideways per tick, gases: sideways jitter, < 0 = default
+	std::vector<std::uint32_t> palette; // 0xRRGGBB, one is picked at random per cell
+	char key;                         // 'A'..'Z' selects the material, 0 = no key
+};
+
+
+// === Lookup ===
+std::size_t getMaterialCount();
+const MaterialInfo& getMaterialInfo(MaterialType type);
+const MaterialInfo& getMaterialInfoByIndex(std::size_t index);
+const std::vector<ReactionRule>& getReactionRules();
+
+const std::vector<MaterialDefinition>& getMaterialDefinitions();
+const MaterialDefinition* findMaterialDefinition(MaterialType type);
+const MaterialDefinition* findMaterialDefinitionByKey(char key);
+
+
+// === Loading ===
+bool loadMaterialDefinitions(const std::string& path);
@@ -6,15 +6,26 @@
 */
 
 // STL
+#include <algorithm>
+#include <memory>
 #include <random>
+#include <type_traits>
 
 // Project headers
 #include "Game.h"
 #include "MaterialEnums.h"
+#include "MaterialTable.h"
 
 
 // Constants
 inline const sf::Color DEFAULT_COLOR = sf::Color(3, 9, 28);
+inline constexpr int LIQUID_DISPERSION = 10;   // maximum sideways flow of liquids, cells per tick
+static_assert(LIQUID_DISPERSION <= GRID_HALO, "liquids probe sideways up to their dispersion, the border must cover it");
+inline constexpr float GAS_BUOYANCY = 0.6f;    // rise speed of gases in still air, cells per tick
+inline constexpr float GAS_DISPERSION = 0.8f;  // maximum sideways jitter of gases, cells per tick
+inline const sf::Color GAS_OVERLAY_COLOR = sf::Color(60, 60, 60);
+inline constexpr float GAS_OVERLAY_OPACITY = 0.85f;
+inline const sf::Color POWERED_COLOR = sf::Color(255, 214, 90);
 
 //////////////////////////    Material class     /////////////////////////
 
@@ -29,12 +40,14 @@ public:
 	MaterialType getType() const;
 	virtual MaterialState getState() const;
 	virtual sf::Color getColor() const;
+	void setColor(sf::Color color);
 	float getDensity() const;
 	bool isUpdated() const;
 	void setUpdated(bool value);
 
 	// Methods
 	virtual void update(int x, int y, Game& game) = 0;
+	virtual bool expire(int x, int y, Game& game) { return false; }  // true if the cell was replaced
 
 protected:
 	// Protected variables
@@ -56,6 +69,21 @@ protected:
 //========================================================================
 
 
+//////////////////////////  BorderMaterial class  /////////////////////////
+
+// Sentinel in the padding around the grid, so the material rules can read their
+// neighbors without bounds checks. Has no state, so no rule ever moves into it.
+class BorderMaterial
+	: public Material {
+public:
+	explicit BorderMaterial(MaterialType type);
+
+	void update(int x, int y, Game& game) override;
+};
+
+//========================================================================
+
+
 //////////////////////////  SolidMaterial class   /////////////////////////
 
 class SolidMaterial
@@ -105,6 +133,8 @@ public:
 
 	void update(int x, int y, Game& game) override;
 protected:
+	int dispersion = LIQUID_DISPERSION;
+
 	virtual sf::Color generateColor() const override = 0;
 };
 
@@ -120,12 +150,52 @@ public:
 
 	void update(int x, int y, Game& game) override;
 protected:
+	float dispersion = GAS_DISPERSION;
+
 	virtual sf::Color generateColor() const override = 0;
 };
 
 //========================================================================
 
 
+/////////////////////////  DefinedMaterial class  ////////////////////////
+
+sf::Color pickPaletteColor(const MaterialDefinition& definition);
+std::unique_ptr<Material> createDefinedMaterial(const MaterialDefinition& definition);
+
+// Material loaded from the definitions file. Base gives it the movement rules
+// of its state, so it runs the same update as a built-in material.
+// Only density and dispersion reach the movement rules; thermal, phase,
+// flammability and reaction rows are read from the table by the field kernels.
+// Movement stays per state class because every cell is a Material object and
+// the grid, its hooks and both engines are built around that.
+template <typename Base>
+class DefinedMaterial
+	: public Base {
+public:
+	explicit DefinedMaterial(const MaterialDefinition& definition)
+		: Base(definition.type, pickPaletteColor(definition), definition.density)
+	{
+		if constexpr (std::is_base_of_v<LiquidMaterial, Base>) {
+			// Sideways probes must stay within the grid border
+			if (definition.dispersion >= 0.0f)
+				this->dispersion = std::min(static_cast<int>(definition.dispersion), GRID_HALO);
+		}
+		else if constexpr (std::is_base_of_v<GaseousMaterial, Base>) {
+			if (definition.dispersion >= 0.0f)
+				this->dispersion = definition.dispersion;
+		}
+	}
+
+protected:
+	sf::Color generateColor() const override {
+		return this->color;
+	}
+};
+
+//========================================================================
+
+
 //////////////////////////  EmptyMaterial class   /////////////////////////
 
 class EmptyMaterial :
@@ -169,6 +239,81 @@ protected:
 //========================================================================
 
 
+///////////////////////////  VentMaterial class  //////////////////////////
+
+class VentMaterial :
+	public SolidUnmovableMaterial
+{
+public:
+	VentMaterial(int x, int y);
+
+protected:
+	sf::Color generateColor(int x, int y) const override;
+};
+
+//========================================================================
+
+
+///////////////////////////  WireMaterial class  //////////////////////////
+
+class WireMaterial :
+	public SolidUnmovableMaterial
+{
+public:
+	WireMaterial();
+
+protected:
+	sf::Color generateColor() const override;
+};
+
+//========================================================================
+
+
+//////////////////////////  BatteryMaterial class  ////////////////////////
+
+class BatteryMaterial :
+	public SolidUnmovableMaterial
+{
+public:
+	BatteryMaterial();
+
+protected:
+	sf::Color generateColor() const override;
+};
+
+//========================================================================
+
+
+/////////////////////////  InverterMaterial class  ////////////////////////
+
+class InverterMaterial :
+	public SolidUnmovableMaterial
+{
+public:
+	InverterMaterial();
+
+protected:
+	sf::Color generateColor() const override;
+};
+
+//========================================================================
+
+
+///////////////////////////  PlantMaterial class  /////////////////////////
+
+class PlantMaterial :
+	public SolidUnmovableMaterial
+{
+public:
+	PlantMaterial();
+
+protected:
+	sf::Color generateColor() const override;
+};
+
+//========================================================================
+
+
 //////////////////////////  DirtMaterial class  //////////////////////////
 
 class DirtMaterial :
@@ -241,4 +386,54 @@ private:
 	sf::Color generateColor() const override;
 };
 
+//========================================================================
+
+
+///////////////////////////  LavaMaterial class  //////////////////////////
+
+class LavaMaterial :
+	public LiquidMaterial
+{
+public:
+	LavaMaterial();
+
+private:
+	sf::Color generateColor() const override;
+};
+
+//========================================================================
+
+
+//////////////////////////  SteamMaterial class  /////////////////////////
+
+class SteamMaterial :
+	public GaseousMaterial
+{
+public:
+	SteamMaterial();
+
+private:
+	sf::Color generateColor() const override;
+};
+
+//========================================================================
+
+
+///////////////////////////  FireMaterial class  //////////////////////////
+
+class FireMaterial :
+	public GaseousMaterial
+{
+public:
+	FireMaterial();
+
+	void update(int x, int y, Game& game) override;
+	bool expire(int x, int y, Game& game) override;
+
+private:
+	int lifetime;          // ticks left before the flame dies out
+
+	sf::Color generateColor() const override;
+};
+
 //========================================================================
\ No newline at end of file
@@ -0,0 +1,95 @@
+#pragma once
+
+/*
+	Class that draws an overview of the whole grid in one small texture.
+	Every chunk of MINIMAP_CHUNK_SIZE x MINIMAP_CHUNK_SIZE cells is one pixel holding
+	the average color of its cells. The grid hooks mark the chunks they touch and
+	only those are summarized again, so a still scene costs nothing and the texture
+	is only uploaded when a pixel changed. Chunks changed in the last
+	MINIMAP_ACTIVE_FRAMES frames are tinted, the rest are dimmed, so the map also
+	shows which areas are active and which are asleep.
+*/
+
+// STL
+#include <cstdint>
+#include <vector>
+
+// SFML
+#include <SFML/Graphics.hpp>
+
+// Project headers
+#include "CellGrid.h"
+
+
+// Constants
+inline constexpr int MINIMAP_CHUNK_SHIFT = CELL_TILE_SHIFT;  // one pixel per storage tile
+inline constexpr int MINIMAP_CHUNK_SIZE = 1 << MINIMAP_CHUNK_SHIFT;
+inline constexpr int MINIMAP_ACTIVE_FRAMES = 60;    // frames a chunk shows as active after its last change
+inline constexpr float MINIMAP_ACTIVE_TINT = 0.35f; // blend of active chunks towards MINIMAP_ACTIVE_COLOR
+inline constexpr float MINIMAP_SLEEP_SHADE = 0.6f;  // brightness of chunks that are asleep
+inline constexpr float MINIMAP_WIDTH = 240.0f;      // on screen, pixels at the base resolution
+inline const sf::Color MINIMAP_ACTIVE_COLOR = sf::Color(255, 120, 60);
+inline const sf::Color MINIMAP_FRAME_COLOR = sf::Color(255, 255, 255, 160);
+
+
+class Minimap
+{
+public:
+	// === Constructors ===
+	Minimap();
+
+	// === Accessors ===
+	int getColumns() const;
+	int getRows() const;
+	std::size_t getActiveCount() const;
+	const std::vector<int>& getDirtyChunks() const;
+
+	// === Grid hooks ===
+	void markChanged(int x, int y);
+	void markColumnChanged(int x, int top, int bottom);
+	void markAll();
+
+	// === Methods ===
+	void resize(int width, int height);
+	void update(const sf::VertexArray& vertices);
+	void place(const sf::Vector2f& position, float width);
+	void draw(sf::RenderWindow& window) const;
+
+private:
+	void summarize(int chunk, const sf::VertexArray& vertices);
+	void shade(int chunk);
+
+private:
+	int width = 0;
+	int height = 0;
+	int columns = 0;
+	int rows = 0;
+	int frame = 0;
+
+	std::vector<std::uint8_t> dirty;
+	std::vector<int> dirtyChunks;
+	std::vector<std::uint8_t> active;
+	std::vector<int> activeChunks;
+	std::vector<int> lastChange;  // frame of the last change of every chunk
+
+	std::vector<sf::Color> summaries;
+	std::vector<sf::Uint8> pixels;  // RGBA, one pixel per chunk
+	bool pixelsChanged = false;
+
+	sf::Texture texture;
+	sf::Sprite sprite;
+	sf::RectangleShape border;
+};
+
+
+// === Inline grid hooks ===
+// Called for every cell the simulation moves
+
+inline void Minimap::markChanged(int x, int y)
+{
+	int chunk = (y >> MINIMAP_CHUNK_SHIFT) * this->columns + (x >> MINIMAP_CHUNK_SHIFT);
+	if (!this->dirty[chunk]) {
+		this->dirty[chunk] = 1;
+		this->dirtyChunks.push_back(chunk);
+	}
+}
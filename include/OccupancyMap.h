@@ -0,0 +1,50 @@
+#pragma once
+
+/*
+	Class that mirrors the grid as per-row bitmaps.
+	One bit per cell for non-empty cells and one for cells that have an update rule,
+	so the update loop can jump between candidates with bit scans instead of
+	visiting every cell.
+*/
+
+// STL
+#include <cstdint>
+#include <vector>
+
+// Project headers
+#include "MaterialEnums.h"
+
+
+class OccupancyMap
+{
+public:
+	// === Constructors ===
+	OccupancyMap();
+
+	// === Accessors ===
+	bool isOccupied(int x, int y) const;
+	bool isMovable(int x, int y) const;
+	bool hasMovable(int y) const;
+	int nextMovable(int x, int y) const;
+	int previousMovable(int x, int y) const;
+
+	// === Grid sync ===
+	void resize(int width, int height);
+	void setMaterial(int x, int y, MaterialType type);
+	void swapCells(int x1, int y1, int x2, int y2);
+
+private:
+	static bool hasUpdateRule(MaterialType type);
+
+	void setBit(std::vector<std::uint64_t>& bits, int x, int y, bool value);
+	bool getBit(const std::vector<std::uint64_t>& bits, int x, int y) const;
+
+private:
+	int width = 0;
+	int height = 0;
+	int wordsPerRow = 0;
+
+	std::vector<std::uint64_t> occupied;
+	std::vector<std::uint64_t> movable;
+	std::vector<int> movableCounts;  // movable cells per row, lets empty rows be skipped
+};
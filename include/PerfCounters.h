@@ -0,0 +1,82 @@
+#pragma once
+
+/*
+	Class that reads hardware performance counters around simulation kernels.
+	Counts cycles, instructions, L1 data and last-level cache misses and branch
+	misses of the calling thread, per region and per tick, through perf_event_open.
+	Only available on Linux; elsewhere, or when the kernel refuses access, open()
+	fails and the regions cost a branch.
+*/
+
+// STL
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+
+// Constants
+inline constexpr std::size_t PERF_EVENT_COUNT = 5;
+inline constexpr std::size_t PERF_REGION_COUNT = 2;
+
+
+// === ENUMS & STRUCTS ===
+enum class PerfEvent { Cycles, Instructions, L1Misses, LLCMisses, BranchMisses };
+enum class PerfRegion { GridUpdate, ColorBuild };
+
+struct PerfReading {
+	std::array<std::uint64_t, PERF_EVENT_COUNT> values{};
+
+	std::uint64_t get(PerfEvent event) const { return this->values[static_cast<std::size_t>(event)]; }
+};
+
+
+class PerfCounters
+{
+public:
+	// === Constructors ===
+	PerfCounters();
+	~PerfCounters();
+
+	PerfCounters(const PerfCounters&) = delete;
+	PerfCounters& operator=(const PerfCounters&) = delete;
+
+	// === Accessors ===
+	bool isOpen() const;
+	bool hasEvent(PerfEvent event) const;
+	const std::string& getError() const;
+	int getTickCount() const;
+	const PerfReading& getTickReading(PerfRegion region) const;
+	const PerfReading& getTotalReading(PerfRegion region) const;
+	static const char* getEventName(PerfEvent event);
+	static const char* getRegionName(PerfRegion region);
+
+	// === Methods ===
+	bool open();
+	void close();
+	void beginTick();
+	void beginRegion();
+	void endRegion(PerfRegion region);
+
+private:
+	// Raw group read, times are used to scale counts when the kernel multiplexes counters
+	struct Snapshot {
+		std::array<std::uint64_t, PERF_EVENT_COUNT> values{};
+		std::uint64_t enabled = 0;
+		std::uint64_t running = 0;
+	};
+
+	bool read(Snapshot& snapshot) const;
+
+private:
+	int groupFd = -1;
+	std::array<int, PERF_EVENT_COUNT> fds;
+	std::array<int, PERF_EVENT_COUNT> positions;  // index of every event in a group read, -1 = not counted
+	int openCount = 0;
+	std::string error;
+
+	Snapshot start;
+	std::array<PerfReading, PERF_REGION_COUNT> tickReadings;
+	std::array<PerfReading, PERF_REGION_COUNT> totalReadings;
+	int ticks = 0;
+};
@@ -0,0 +1,59 @@
+#pragma once
+
+/*
+	Class that resolves reactions between neighbouring materials.
+	Driven by a dense (material, neighbour) matrix and a sparse set of candidate cells.
+*/
+
+// STL
+#include <cstdint>
+#include <vector>
+
+// Project headers
+#include "MaterialTable.h"
+
+
+// === Forward declarations ===
+class Game;
+
+
+class ReactionEngine
+{
+public:
+	// === Constructors ===
+	ReactionEngine();
+
+	// === Accessors ===
+	std::size_t getActiveCount() const;
+	bool isIdle() const;
+
+	// === Grid sync ===
+	void resize(int width, int height);
+	void track(int x, int y, MaterialType type);
+
+	// === Main logic ===
+	void update(Game& game);
+
+private:
+	struct Reaction {
+		MaterialType selfProduct;
+		MaterialType neighborProduct;
+		std::uint32_t threshold;       // reacts when a 32-bit random value is below it, 0 = no reaction
+	};
+
+	void addReaction(MaterialType self, MaterialType neighbor,
+		MaterialType selfProduct, MaterialType neighborProduct, float chance);
+
+private:
+	// === Rules ===
+	std::size_t materialCount = 0;
+	std::vector<Reaction> matrix;      // materialCount x materialCount
+	std::vector<std::uint8_t> reactive;
+
+	// === Candidate cells ===
+	int width = 0;
+	int height = 0;
+	std::vector<int> active;
+	std::vector<int> processing;
+	std::vector<std::uint8_t> queued;
+};
@@ -0,0 +1,56 @@
+#pragma once
+
+/*
+	Encoding of replay files.
+
+	File   : "SBRP" version:u8 width:varint height:varint, then one record per tick
+	Record : type:u8 ('K' keyframe, 'D' delta) size:varint payload[size]
+	Cells  : 0xIIRRGGBB, material index and displayed color
+
+	Keyframe payload : (count:varint value)...                run-length over every cell
+	Delta payload    : (skip:varint length:varint values)...  runs of changed cells,
+	                   values run-length encoded the same way as a keyframe
+	Value            : code:varint, 0 = new value u32 follows, otherwise palette[code - 1]
+
+	The palette collects every value written since the last keyframe, so the few
+	hundred colors of a scene cost one or two bytes after their first use. It is
+	cleared by each keyframe, which keeps every keyframe a valid seek point.
+*/
+
+// STL
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+
+// Constants
+inline constexpr char REPLAY_MAGIC[4] = { 'S', 'B', 'R', 'P' };
+inline constexpr std::uint8_t REPLAY_VERSION = 1;
+inline constexpr int REPLAY_KEYFRAME_INTERVAL = 300;  // ticks between keyframes
+
+enum class ReplayRecord : std::uint8_t { Keyframe = 'K', Delta = 'D' };
+
+
+struct ReplayPalette {
+	std::vector<std::uint32_t> values;
+	std::unordered_map<std::uint32_t, std::uint32_t> codes;
+
+	void clear()
+	{
+		this->values.clear();
+		this->codes.clear();
+	}
+};
+
+
+// === Primitives ===
+void writeVarint(std::vector<std::uint8_t>& out, std::uint64_t value);
+bool readVarint(const std::uint8_t*& data, const std::uint8_t* end, std::uint64_t& value);
+
+// === Records ===
+void encodeKeyframe(const std::vector<std::uint32_t>& cells, ReplayPalette& palette, std::vector<std::uint8_t>& out);
+void encodeDelta(const std::vector<std::uint32_t>& previous, const std::vector<std::uint32_t>& cells,
+	ReplayPalette& palette, std::vector<std::uint8_t>& out);
+bool decodeKeyframe(const std::vector<std::uint8_t>& payload, ReplayPalette& palette, std::vector<std::uint32_t>& cells);
+bool decodeDelta(const std::vector<std::uint8_t>& payload, ReplayPalette& palette, std::vector<std::uint32_t>& cells);
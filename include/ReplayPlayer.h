@@ -0,0 +1,59 @@
+#pragma once
+
+/*
+	Class that plays back a replay file.
+	Indexes the records on open, then rebuilds any tick from the keyframe before it
+	plus the deltas in between. Playing forward only applies deltas, which costs far
+	less than simulating.
+*/
+
+// STL
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// Project headers
+#include "ReplayFormat.h"
+
+
+// Constants
+inline constexpr int REPLAY_SEEK_TICKS = 120;  // ticks skipped by one seek key press
+inline constexpr int REPLAY_MAX_SPEED = 64;
+
+class ReplayPlayer
+{
+public:
+	// === Constructors ===
+	ReplayPlayer();
+
+	// === Accessors ===
+	int getWidth() const;
+	int getHeight() const;
+	int getTick() const;
+	int getTickCount() const;
+	const std::vector<std::uint32_t>& getCells() const;
+
+	// === Methods ===
+	bool open(const std::string& path);
+	bool seek(int tick);
+	bool advance(int ticks);
+
+private:
+	bool applyRecord(int tick);
+
+private:
+	std::ifstream file;
+	int width = 0;
+	int height = 0;
+	int tick = -1;
+
+	std::vector<std::uint64_t> offsets;   // file position of every tick's payload
+	std::vector<std::uint32_t> sizes;
+	std::vector<ReplayRecord> types;
+	std::vector<int> keyframes;
+
+	std::vector<std::uint32_t> cells;
+	ReplayPalette palette;
+	std::vector<std::uint8_t> payload;
+};
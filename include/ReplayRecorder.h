@@ -0,0 +1,51 @@
+#pragma once
+
+/*
+	Class that writes a replay file.
+	Every recorded tick becomes a delta against the tick before it, with a keyframe
+	every few hundred ticks so the player can seek without reading the whole file.
+*/
+
+// STL
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// Project headers
+#include "ReplayFormat.h"
+
+
+class ReplayRecorder
+{
+public:
+	// === Constructors ===
+	ReplayRecorder();
+	~ReplayRecorder();
+
+	// === Accessors ===
+	bool isRecording() const;
+	const std::string& getPath() const;
+	int getTickCount() const;
+	std::uint64_t getByteCount() const;
+
+	// === Methods ===
+	bool open(const std::string& path, int width, int height, int keyframeInterval = REPLAY_KEYFRAME_INTERVAL);
+	void record(const std::vector<std::uint32_t>& cells);
+	void close();
+
+private:
+	void writeRecord(ReplayRecord type);
+
+private:
+	std::ofstream file;
+	std::string path;
+	int keyframeInterval = REPLAY_KEYFRAME_INTERVAL;
+	int ticks = 0;
+	std::uint64_t bytes = 0;
+
+	std::vector<std::uint32_t> previous;
+	ReplayPalette palette;
+	std::vector<std::uint8_t> payload;
+	std::vector<std::uint8_t> header;
+};
@@ -0,0 +1,115 @@
+#pragma once
+
+/*
+	Class that keeps the last seconds of the simulation for stepping backwards.
+	Ticks are stored in the replay encoding: segments that start with a keyframe and
+	continue with per-tick deltas. A tick only packs the chunks changed since the
+	last captured tick, the chunk grid is the minimap's so its change marks are
+	reused. A background thread applies those chunks to its own copy of the grid
+	and encodes it. When the encoder falls behind the tick is dropped, its chunks
+	stay pending for the next one, so the simulation never waits. The oldest
+	segments are dropped once the rest still covers the time window, or when the
+	buffer exceeds its memory limit.
+*/
+
+// STL
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Project headers
+#include "CellGrid.h"
+#include "ReplayFormat.h"
+#include "ThreadPool.h"
+
+
+// Constants
+inline constexpr int REWIND_WINDOW_TICKS = 20 * 120;                   // 20 s at the 120 FPS frame limit
+inline constexpr int REWIND_KEYFRAME_INTERVAL = 120;                   // ticks per segment
+inline constexpr std::size_t REWIND_MEMORY_LIMIT = 256 * 1024 * 1024;  // bytes of encoded ticks kept
+inline constexpr std::size_t REWIND_QUEUE_LIMIT = 4;                   // frames waiting for the encoder at most
+inline constexpr int REWIND_CHUNK_SHIFT = CELL_TILE_SHIFT;             // same chunks as the minimap
+inline constexpr int REWIND_CHUNK_SIZE = 1 << REWIND_CHUNK_SHIFT;
+inline constexpr int REWIND_SCRUB_STEP = 10;                           // ticks per step with Shift held
+
+
+// === ENUMS & STRUCTS ===
+// Chunks changed since the last captured tick, packed as 0xIIRRGGBB
+struct RewindFrame {
+	int width = 0;
+	int height = 0;
+	std::vector<int> chunks;           // chunk ids, row major over the chunk grid
+	std::vector<std::uint32_t> cells;  // REWIND_CHUNK_SIZE^2 cells per chunk, row major, cells past the grid edge unused
+};
+
+
+class RewindBuffer
+{
+public:
+	// === Constructors ===
+	explicit RewindBuffer(int windowTicks = REWIND_WINDOW_TICKS, std::size_t memoryLimit = REWIND_MEMORY_LIMIT);
+	~RewindBuffer();
+
+	// === Accessors ===
+	int getFirstTick() const;
+	int getLastTick() const;
+	std::size_t getByteCount() const;
+
+	// === Grid sync ===
+	void resize(int width, int height);
+	void markChanged(const std::vector<int>& chunks);
+
+	// === Methods ===
+	void clear();
+	RewindFrame* acquire();
+	void submit(RewindFrame* frame);
+	bool restore(int tick, std::vector<std::uint32_t>& cells);
+	void truncate(int tick);
+
+private:
+	struct Segment {
+		int firstTick;
+		std::vector<std::uint8_t> data;
+		std::vector<std::size_t> ends;  // end of every tick's payload in data
+	};
+
+	void flush();
+	void encode(RewindFrame* frame, int tick);
+	void trim();
+
+private:
+	int windowTicks;
+	std::size_t memoryLimit;
+	int lastTick = -1;  // last submitted tick, owned by the caller's thread
+
+	// === Pending chunks, owned by the caller's thread ===
+	int width = 0;
+	int height = 0;
+	std::vector<std::uint8_t> pending;  // 1 if the chunk changed since the last captured tick
+	std::vector<int> pendingChunks;
+
+	// === Encoder state, used by the encoder thread only ===
+	std::vector<std::uint32_t> current;
+	std::vector<std::uint32_t> previous;
+	ReplayPalette palette;
+	std::vector<std::uint8_t> payload;
+
+	// === Timeline ===
+	std::deque<Segment> segments;
+	std::size_t bytes = 0;
+	bool startSegment = true;
+	std::vector<std::uint8_t> decodePayload;
+
+	// === Buffers ===
+	std::vector<std::unique_ptr<RewindFrame>> buffers;
+	std::vector<RewindFrame*> freeBuffers;
+	std::size_t inFlight = 0;
+	mutable std::mutex mutex;
+	std::condition_variable bufferReturned;
+
+	// One worker keeps the frames in order. Declared last so it stops before the buffers go away
+	ThreadPool encoder;
+};
@@ -0,0 +1,84 @@
+#pragma once
+
+/*
+	Class that lets structures of stone and brick fall when nothing holds them up.
+	Connected cells form a component. Components are tracked with union-find over
+	component ids: placing a cell unions it with its neighbors, and removing one
+	starts searches from the cells around it that stop as soon as the pieces meet
+	again, so only a piece that really broke off is relabeled. A component is checked for
+	support only after something under it changed, and an unsupported one moves
+	down one cell per tick as a single block.
+*/
+
+// STL
+#include <cstdint>
+#include <vector>
+
+// Project headers
+#include "MaterialEnums.h"
+
+
+// Constants
+inline constexpr std::size_t RIGID_COMPACT_FACTOR = 4;      // component ids per rigid cell before the ids are compacted
+inline constexpr std::size_t RIGID_COMPACT_MINIMUM = 4096;  // ids always allowed, so small scenes never compact
+
+
+// === Forward declarations ===
+class Game;
+
+
+class RigidBodies
+{
+public:
+	// === Constructors ===
+	RigidBodies();
+
+	// === Accessors ===
+	static bool isRigid(MaterialType type);
+	static bool isPassable(MaterialType type);
+	int getComponent(int x, int y);
+	std::size_t getFallingCount() const;
+	bool isIdle() const;
+
+	// === Grid sync ===
+	void resize(int width, int height);
+	void setMaterial(int x, int y, MaterialType previous, MaterialType material);
+	void swapCells(int x1, int y1, int x2, int y2, MaterialType type1, MaterialType type2);
+	void shiftColumnDown(int x, int top);
+
+	// === Main logic ===
+	void update(Game& game);
+
+private:
+	int find(int id);
+	int unite(int a, int b);
+	int newComponent();
+	void compact();
+	void addCell(int c);
+	void removeCell(int c);
+	void markBelowChanged(int x, int y);
+	void splitRemoved();
+	void separate(const std::vector<int>& starts, int root);
+	bool collect(Game& game, int c, std::vector<int>& cells);
+	void moveDown(Game& game, std::vector<int>& body);
+
+private:
+	int width = 0;
+	int height = 0;
+
+	std::vector<std::uint8_t> rigid;  // 1 for cells of rigid materials
+	std::vector<int> labels;          // component id of every rigid cell
+	std::vector<int> parents;         // union-find over component ids
+	std::size_t rigidCount = 0;
+
+	std::vector<int> removed;         // rigid cells removed since the last update
+	std::vector<int> unsettled;       // rigid cells whose component must be checked for support
+	std::size_t falling = 0;
+	bool moving = false;              // set while update moves blocks, the hooks ignore its own moves
+
+	// === Search scratch ===
+	std::vector<int> visits;          // visit stamp per cell
+	int stamp = 0;
+	std::vector<int> stack;
+	std::vector<int> cells;
+};
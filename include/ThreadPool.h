@@ -0,0 +1,44 @@
+#pragma once
+
+/*
+	Fixed-size pool of worker threads.
+	Used to split field simulations across rows and to run background jobs.
+*/
+
+// STL
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+class ThreadPool
+{
+public:
+	// === Constructors ===
+	explicit ThreadPool(unsigned threadCount = std::thread::hardware_concurrency(), const std::string& name = "Worker");
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	// === Accessors ===
+	unsigned getThreadCount() const;
+
+	// === Methods ===
+	void submit(std::function<void()> task);
+	void parallelFor(int begin, int end, const std::function<void(int, int)>& body, int grain = 1);
+
+private:
+	void workerLoop(std::string name);
+
+private:
+	std::vector<std::thread> workers;
+	std::queue<std::function<void()>> tasks;
+	std::mutex mutex;
+	std::condition_variable taskAvailable;
+	bool stopping = false;
+};
@@ -0,0 +1,77 @@
+#pragma once
+
+/*
+	Timeline tracing of frames and worker threads.
+	TRACE_SCOPE marks a zone that is timed from its line to the end of the block.
+	While tracing is on, every thread writes its zones into its own ring buffer
+	without locks; the buffers are written out as Chrome trace-event JSON, which
+	Perfetto and chrome://tracing open. While tracing is off a zone costs one
+	relaxed atomic load, so the zones stay in release builds.
+*/
+
+// STL
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+
+// Constants
+inline constexpr std::size_t TRACE_BUFFER_EVENTS = 1 << 16;  // zones kept per thread, a power of two
+
+
+class Tracer
+{
+public:
+	// === Accessors ===
+	static bool isEnabled();
+
+	// === Methods ===
+	static void start();
+	static void stop();
+	static void setThreadName(const std::string& name);
+	static bool write(const std::string& path);
+
+	// === Recording ===
+	static void record(const char* name, std::int64_t start, std::int64_t end);
+	static std::int64_t now();
+
+private:
+	static inline std::atomic<bool> enabled{ false };
+};
+
+
+// Inline, it is checked by every zone
+inline bool Tracer::isEnabled()
+{
+	return enabled.load(std::memory_order_relaxed);
+}
+
+
+class TraceScope
+{
+public:
+	// === Constructors ===
+	explicit TraceScope(const char* name)
+		: name(Tracer::isEnabled() ? name : nullptr),
+		start(this->name ? Tracer::now() : 0) { }
+
+	~TraceScope()
+	{
+		if (this->name)
+			Tracer::record(this->name, this->start, Tracer::now());
+	}
+
+	TraceScope(const TraceScope&) = delete;
+	TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+	const char* name;  // nullptr when tracing was off as the zone began
+	std::int64_t start;
+};
+
+
+// Zone names must outlive the trace, use string literals
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+#define TRACE_SCOPE(name) TraceScope TRACE_CONCAT(traceScope, __LINE__)(name)
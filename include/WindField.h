@@ -0,0 +1,66 @@
+#pragma once
+
+/*
+	Class that represents air flow over the grid.
+	Coarse velocity field (one sample per WIND_CELL_SIZE x WIND_CELL_SIZE cells)
+	advanced with a stable-fluids step. Biases the movement of gases.
+*/
+
+// STL
+#include <vector>
+
+// SFML
+#include <SFML/Graphics.hpp>
+
+// Project headers
+#include "HeatField.h"
+#include "MaterialEnums.h"
+#include "ThreadPool.h"
+
+
+// Constants
+inline constexpr int WIND_CELL_SIZE = 8;       // grid cells per wind sample on each axis
+inline constexpr int WIND_UPDATE_INTERVAL = 2; // movement ticks per wind tick
+
+
+class WindField
+{
+public:
+	// === Constructors ===
+	WindField();
+
+	// === Accessors ===
+	sf::Vector2f getVelocity(int x, int y) const;
+
+	// === Grid sync ===
+	void resize(int gridWidth, int gridHeight);
+	void replaceMaterial(int x, int y, MaterialType previous, MaterialType material);
+
+	// === Main logic ===
+	void step(ThreadPool& pool, const HeatField& heat);
+
+private:
+	int index(int i, int j) const;
+
+	void addForces(ThreadPool& pool, const HeatField& heat);
+	void advect(ThreadPool& pool);
+	void project(ThreadPool& pool);
+
+private:
+	// === Field size (padded by one sample on every side) ===
+	int width = 0;
+	int height = 0;
+	int stride = 0;
+	int gridWidth = 0;
+	int gridHeight = 0;
+
+	// === Samples ===
+	std::vector<float> u;              // horizontal velocity, grid cells per tick
+	std::vector<float> v;              // vertical velocity, grid cells per tick (positive is down)
+	std::vector<float> previousU;
+	std::vector<float> previousV;
+	std::vector<float> pressure;
+	std::vector<float> nextPressure;
+	std::vector<float> divergence;
+	std::vector<int> vents;            // vent cells inside each sample
+};
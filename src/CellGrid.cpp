@@ -0,0 +1,49 @@
+#include "CellGrid.h"
+
+// Project headers
+#include "Materials.h"
+
+// === Constructors ===
+CellGrid::CellGrid() { }
+
+CellGrid::~CellGrid() { }
+
+// === Accessors ===
+int CellGrid::getTileColumns() const
+{
+	/*
+		@return int - tiles across the grid itself, the first one starts at x = 0
+	*/
+
+	return (this->width + CELL_TILE_SIZE - 1) / CELL_TILE_SIZE;
+}
+
+int CellGrid::getTileRows() const
+{
+	/*
+		@return int - tiles down the grid itself, the first one starts at y = 0
+	*/
+
+	return (this->height + CELL_TILE_SIZE - 1) / CELL_TILE_SIZE;
+}
+
+// === Methods ===
+void CellGrid::resize(int width, int height)
+{
+	/*
+		@return void
+
+		Drops every cell. The grid and its border are empty pointers afterwards.
+	*/
+
+	this->width = width;
+	this->height = height;
+
+	int storageWidth = CELL_TILE_ORIGIN + width + GRID_HALO;
+	int storageHeight = CELL_TILE_ORIGIN + height + GRID_HALO;
+	this->tilesPerRow = (storageWidth + CELL_TILE_SIZE - 1) / CELL_TILE_SIZE;
+	int tileRows = (storageHeight + CELL_TILE_SIZE - 1) / CELL_TILE_SIZE;
+
+	this->cells.clear();
+	this->cells.resize(static_cast<std::size_t>(this->tilesPerRow) * tileRows * CELL_TILE_SIZE * CELL_TILE_SIZE);
+}
@@ -0,0 +1,491 @@
+#include "Circuit.h"
+
+// Project headers
+#include "Tracer.h"
+
+// STL
+#include <algorithm>
+
+namespace {
+	const int UNVISITED = -2;
+
+	CircuitPart partOf(MaterialType type)
+	{
+		switch (type) {
+			case MaterialType::Wire: return CircuitPart::Wire;
+			case MaterialType::Battery: return CircuitPart::Battery;
+			case MaterialType::Inverter: return CircuitPart::Inverter;
+			default: return CircuitPart::None;
+		}
+	}
+}
+
+// === Constructors ===
+Circuit::Circuit() { }
+
+// === Accessors ===
+bool Circuit::isPowered(int x, int y) const
+{
+	int c = y * this->width + x;
+
+	switch (this->parts[c]) {
+		case CircuitPart::Wire: return this->networks[this->labels[c]].powered;
+		case CircuitPart::Inverter: return this->outputs[c] != 0;
+		default: return false;
+	}
+}
+
+bool Circuit::isIdle() const
+{
+	return this->dirtyNetworks.empty() && this->brokenNetworks.empty() && this->scheduledGates.empty();
+}
+
+// === Grid sync ===
+void Circuit::resize(int width, int height)
+{
+	this->width = width;
+	this->height = height;
+
+	std::size_t size = static_cast<std::size_t>(width) * height;
+	this->parts.assign(size, CircuitPart::None);
+	this->labels.assign(size, -1);
+	this->slots.assign(size, -1);
+	this->outputs.assign(size, 0);
+	this->scheduled.assign(size, 0);
+
+	this->networks.clear();
+	this->freeNetworks.clear();
+	this->dirtyNetworks.clear();
+	this->brokenNetworks.clear();
+	this->scheduledGates.clear();
+	this->evaluatingGates.clear();
+}
+
+void Circuit::setMaterial(int x, int y, MaterialType type)
+{
+	/*
+		@return void
+
+		Keeps the circuit in sync with a painted or erased cell.
+		Costs one table check for anything that is not a circuit part.
+	*/
+
+	int c = y * this->width + x;
+	CircuitPart previous = this->parts[c];
+	CircuitPart part = partOf(type);
+
+	if (previous == part) return;
+
+	switch (previous) {
+		case CircuitPart::Wire: this->removeWire(c); break;
+		case CircuitPart::Battery: this->removeBattery(c); break;
+		case CircuitPart::Inverter: this->removeInverter(c); break;
+		default: break;
+	}
+
+	switch (part) {
+		case CircuitPart::Wire: this->addWire(c); break;
+		case CircuitPart::Battery: this->addBattery(c); break;
+		case CircuitPart::Inverter: this->addInverter(c); break;
+		default: break;
+	}
+}
+
+// === Main logic ===
+void Circuit::update()
+{
+	/*
+		@return void
+
+		- rebuild networks that erasing may have split
+		- switch gates scheduled on the previous tick
+		- settle wire networks whose drivers changed
+
+		Advances signals by one gate delay. Does nothing while the worklists are empty.
+	*/
+
+	TRACE_SCOPE("Circuits");
+
+	for (int id : this->brokenNetworks)
+		if (this->networks[id].alive && this->networks[id].broken)
+			this->rebuildNetwork(id);
+	this->brokenNetworks.clear();
+
+	this->evaluatingGates.swap(this->scheduledGates);
+	this->scheduledGates.clear();
+
+	for (int c : this->evaluatingGates)
+		this->scheduled[c] = 0;
+
+	for (int c : this->evaluatingGates) {
+		if (this->parts[c] != CircuitPart::Inverter) continue;
+
+		bool on = !this->readInput(c);
+		if (on != (this->outputs[c] != 0))
+			this->setInverterOutput(c, on);
+	}
+
+	for (int id : this->dirtyNetworks) {
+		Network& network = this->networks[id];
+		network.queued = false;
+		if (!network.alive) continue;
+
+		bool powered = network.drivers > 0;
+		if (powered == network.powered) continue;
+
+		network.powered = powered;
+		for (int reader : network.readers)
+			this->scheduleGate(reader);
+	}
+	this->dirtyNetworks.clear();
+}
+
+// === Parts ===
+void Circuit::addWire(int c)
+{
+	this->parts[c] = CircuitPart::Wire;
+
+	// Join the largest neighbouring network and merge the others into it
+	int id = -1;
+	for (int side = 0; side < 4; side++) {
+		int n = this->neighbor(c, side);
+		if (n < 0 || this->parts[n] != CircuitPart::Wire) continue;
+
+		int other = this->labels[n];
+		if (id < 0)
+			id = other;
+		else if (other != id) {
+			if (this->networks[other].cells.size() > this->networks[id].cells.size())
+				std::swap(id, other);
+			this->mergeNetwork(other, id);
+		}
+	}
+
+	if (id < 0)
+		id = this->createNetwork();
+
+	this->addCell(id, c);
+	this->collectContacts(id, c);
+	this->queueNetwork(id);
+}
+
+void Circuit::removeWire(int c)
+{
+	int id = this->labels[c];
+	this->removeContacts(id, c);
+	this->labels[c] = -1;
+	this->parts[c] = CircuitPart::None;
+
+	int wireNeighbors = 0;
+	for (int side = 0; side < 4; side++) {
+		int n = this->neighbor(c, side);
+		if (n >= 0 && this->labels[n] == id)
+			wireNeighbors++;
+	}
+
+	// Swap the last cell into the erased one's slot, so erasing and repainting never grows the list
+	Network& network = this->networks[id];
+	int last = network.cells.back();
+	network.cells[this->slots[c]] = last;
+	this->slots[last] = this->slots[c];
+	network.cells.pop_back();
+	this->slots[c] = -1;
+
+	if (network.cells.empty()) {
+		// It was the last cell of the network. A cell without wire neighbours may still
+		// belong to a network split by an earlier erase, its other parts keep it alive
+		for (int reader : network.readers)
+			this->scheduleGate(reader);
+		this->releaseNetwork(id);
+		return;
+	}
+
+	// Only a cell joining two or more branches can split the network;
+	// the split is resolved once per tick however many cells were erased
+	if (wireNeighbors >= 2 && !network.broken) {
+		network.broken = true;
+		this->brokenNetworks.push_back(id);
+	}
+
+	this->queueNetwork(id);
+}
+
+void Circuit::addBattery(int c)
+{
+	this->parts[c] = CircuitPart::Battery;
+
+	for (int side = 0; side < 4; side++) {
+		int n = this->neighbor(c, side);
+		if (n >= 0 && this->parts[n] == CircuitPart::Wire) {
+			this->networks[this->labels[n]].drivers++;
+			this->queueNetwork(this->labels[n]);
+		}
+	}
+
+	int e = this->east(c);
+	if (e >= 0 && this->parts[e] == CircuitPart::Inverter)
+		this->scheduleGate(e);
+}
+
+void Circuit::removeBattery(int c)
+{
+	this->parts[c] = CircuitPart::None;
+
+	for (int side = 0; side < 4; side++) {
+		int n = this->neighbor(c, side);
+		if (n >= 0 && this->parts[n] == CircuitPart::Wire) {
+			this->networks[this->labels[n]].drivers--;
+			this->queueNetwork(this->labels[n]);
+		}
+	}
+
+	int e = this->east(c);
+	if (e >= 0 && this->parts[e] == CircuitPart::Inverter)
+		this->scheduleGate(e);
+}
+
+void Circuit::addInverter(int c)
+{
+	this->parts[c] = CircuitPart::Inverter;
+	this->outputs[c] = 0;
+
+	int w = this->west(c);
+	if (w >= 0 && this->parts[w] == CircuitPart::Wire)
+		this->networks[this->labels[w]].readers.push_back(c);
+
+	this->scheduleGate(c);
+}
+
+void Circuit::removeInverter(int c)
+{
+	if (this->outputs[c])
+		this->setInverterOutput(c, false);
+
+	int w = this->west(c);
+	if (w >= 0 && this->parts[w] == CircuitPart::Wire) {
+		std::vector<int>& readers = this->networks[this->labels[w]].readers;
+		readers.erase(std::remove(readers.begin(), readers.end(), c), readers.end());
+	}
+
+	this->parts[c] = CircuitPart::None;
+}
+
+// === Signals ===
+bool Circuit::readInput(int c) const
+{
+	int w = this->west(c);
+	if (w < 0) return false;
+
+	switch (this->parts[w]) {
+		case CircuitPart::Wire: return this->networks[this->labels[w]].powered;
+		case CircuitPart::Battery: return true;
+		case CircuitPart::Inverter: return this->outputs[w] != 0;
+		default: return false;
+	}
+}
+
+void Circuit::setInverterOutput(int c, bool on)
+{
+	this->outputs[c] = on ? 1 : 0;
+
+	int e = this->east(c);
+	if (e < 0) return;
+
+	if (this->parts[e] == CircuitPart::Wire) {
+		this->networks[this->labels[e]].drivers += on ? 1 : -1;
+		this->queueNetwork(this->labels[e]);
+	}
+	else if (this->parts[e] == CircuitPart::Inverter)
+		this->scheduleGate(e);
+}
+
+void Circuit::scheduleGate(int c)
+{
+	if (this->scheduled[c]) return;
+
+	this->scheduled[c] = 1;
+	this->scheduledGates.push_back(c);
+}
+
+void Circuit::queueNetwork(int id)
+{
+	Network& network = this->networks[id];
+	if (network.queued) return;
+
+	network.queued = true;
+	this->dirtyNetworks.push_back(id);
+}
+
+// === Networks ===
+int Circuit::createNetwork()
+{
+	int id;
+	if (!this->freeNetworks.empty()) {
+		id = this->freeNetworks.back();
+		this->freeNetworks.pop_back();
+	}
+	else {
+		id = static_cast<int>(this->networks.size());
+		this->networks.emplace_back();
+	}
+
+	// A queued flag may survive from the released network, its worklist entry is still pending
+	bool queued = this->networks[id].queued;
+	this->networks[id] = Network();
+	this->networks[id].alive = true;
+	this->networks[id].queued = queued;
+	return id;
+}
+
+void Circuit::releaseNetwork(int id)
+{
+	Network& network = this->networks[id];
+	network.alive = false;
+	network.broken = false;
+	network.cells.clear();
+	network.cells.shrink_to_fit();
+	network.readers.clear();
+	this->freeNetworks.push_back(id);
+}
+
+void Circuit::addCell(int id, int c)
+{
+	std::vector<int>& cells = this->networks[id].cells;
+	this->labels[c] = id;
+	this->slots[c] = static_cast<int>(cells.size());
+	cells.push_back(c);
+}
+
+void Circuit::mergeNetwork(int from, int into)
+{
+	Network& source = this->networks[from];
+	Network& target = this->networks[into];
+
+	for (int c : source.cells)
+		this->addCell(into, c);
+
+	// Readers of the absorbed network see the merged state on the next tick
+	if (source.powered != target.powered)
+		for (int reader : source.readers)
+			this->scheduleGate(reader);
+
+	target.drivers += source.drivers;
+	target.readers.insert(target.readers.end(), source.readers.begin(), source.readers.end());
+
+	if (source.broken && !target.broken) {
+		target.broken = true;
+		this->brokenNetworks.push_back(into);
+	}
+
+	this->releaseNetwork(from);
+	this->queueNetwork(into);
+}
+
+void Circuit::rebuildNetwork(int id)
+{
+	/*
+		@return void
+
+		Relabels the cells that are left in a network after erasing,
+		splitting it into connected parts. Touches only that network.
+	*/
+
+	std::vector<int> cells = std::move(this->networks[id].cells);
+	std::vector<int> readers = std::move(this->networks[id].readers);
+	bool powered = this->networks[id].powered;
+	this->releaseNetwork(id);
+
+	for (int c : cells)
+		this->labels[c] = UNVISITED;
+
+	std::vector<int> stack;
+	for (int start : cells) {
+		if (this->labels[start] != UNVISITED) continue;
+
+		int part = this->createNetwork();
+		this->networks[part].powered = powered;
+		this->addCell(part, start);
+		stack.push_back(start);
+
+		while (!stack.empty()) {
+			int c = stack.back();
+			stack.pop_back();
+
+			this->collectContacts(part, c);
+
+			for (int side = 0; side < 4; side++) {
+				int n = this->neighbor(c, side);
+				if (n >= 0 && this->labels[n] == UNVISITED) {
+					this->addCell(part, n);
+					stack.push_back(n);
+				}
+			}
+		}
+
+		this->queueNetwork(part);
+	}
+
+	for (int reader : readers)
+		this->scheduleGate(reader);
+}
+
+void Circuit::collectContacts(int id, int c)
+{
+	// Sources touching the cell
+	for (int side = 0; side < 4; side++) {
+		int n = this->neighbor(c, side);
+		if (n >= 0 && this->parts[n] == CircuitPart::Battery)
+			this->networks[id].drivers++;
+	}
+
+	int w = this->west(c);
+	if (w >= 0 && this->parts[w] == CircuitPart::Inverter && this->outputs[w])
+		this->networks[id].drivers++;
+
+	// Gate reading from the cell
+	int e = this->east(c);
+	if (e >= 0 && this->parts[e] == CircuitPart::Inverter) {
+		this->networks[id].readers.push_back(e);
+		this->scheduleGate(e);
+	}
+}
+
+void Circuit::removeContacts(int id, int c)
+{
+	for (int side = 0; side < 4; side++) {
+		int n = this->neighbor(c, side);
+		if (n >= 0 && this->parts[n] == CircuitPart::Battery)
+			this->networks[id].drivers--;
+	}
+
+	int w = this->west(c);
+	if (w >= 0 && this->parts[w] == CircuitPart::Inverter && this->outputs[w])
+		this->networks[id].drivers--;
+
+	int e = this->east(c);
+	if (e >= 0 && this->parts[e] == CircuitPart::Inverter) {
+		std::vector<int>& readers = this->networks[id].readers;
+		readers.erase(std::remove(readers.begin(), readers.end(), e), readers.end());
+		this->scheduleGate(e);
+	}
+}
+
+int Circuit::west(int c) const
+{
+	return c % this->width > 0 ? c - 1 : -1;
+}
+
+int Circuit::east(int c) const
+{
+	return c % this->width < this->width - 1 ? c + 1 : -1;
+}
+
+int Circuit::neighbor(int c, int side) const
+{
+	switch (side) {
+		case 0: return this->west(c);
+		case 1: return this->east(c);
+		case 2: return c >= this->width ? c - this->width : -1;
+		default: return c < (this->height - 1) * this->width ? c + this->width : -1;
+	}
+}
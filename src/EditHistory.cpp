@@ -0,0 +1,279 @@
+#include "EditHistory.h"
+
+// Project headers
+#include "Game.h"
+#include "Materials.h"
+
+// STL
+#include <algorithm>
+
+// === Constructors ===
+EditHistory::EditHistory()
+{
+	auto empty = std::make_shared<ChunkSnapshot>();
+	empty->types.fill(MaterialType::Empty);
+	empty->colors.fill(sf::Color::Transparent);
+	this->emptySnapshot = empty;
+}
+
+// === Accessors ===
+bool EditHistory::canUndo() const
+{
+	return !this->undoStrokes.empty();
+}
+
+bool EditHistory::canRedo() const
+{
+	return !this->redoStrokes.empty();
+}
+
+std::size_t EditHistory::getMemoryUsage() const
+{
+	return this->memoryUsage;
+}
+
+// === Grid sync ===
+void EditHistory::resize(int width, int height)
+{
+	this->width = width;
+	this->height = height;
+	this->chunkColumns = (width + HISTORY_CHUNK_SIZE - 1) / HISTORY_CHUNK_SIZE;
+	this->chunkRows = (height + HISTORY_CHUNK_SIZE - 1) / HISTORY_CHUNK_SIZE;
+
+	std::size_t count = static_cast<std::size_t>(this->chunkColumns) * this->chunkRows;
+	this->snapshots.assign(count, nullptr);
+	this->changed.assign(count, 1);
+	this->touched.assign(count, 0);
+
+	// Snapshots of another grid size can not be restored
+	this->stroke = Stroke();
+	this->stroking = false;
+	this->undoStrokes.clear();
+	this->redoStrokes.clear();
+	this->memoryUsage = 0;
+}
+
+void EditHistory::markChanged(int x, int y)
+{
+	this->changed[(y / HISTORY_CHUNK_SIZE) * this->chunkColumns + x / HISTORY_CHUNK_SIZE] = 1;
+}
+
+void EditHistory::markColumnChanged(int x, int top, int bottom)
+{
+	for (int cy = top / HISTORY_CHUNK_SIZE; cy <= bottom / HISTORY_CHUNK_SIZE; cy++)
+		this->changed[cy * this->chunkColumns + x / HISTORY_CHUNK_SIZE] = 1;
+}
+
+// === Strokes ===
+bool EditHistory::isStroking() const
+{
+	return this->stroking;
+}
+
+void EditHistory::beginStroke()
+{
+	this->endStroke();
+	this->stroking = true;
+}
+
+void EditHistory::touchArea(Game& game, int left, int top, int right, int bottom)
+{
+	/*
+		@return void
+
+		Saves every chunk of the area the current stroke has not saved yet.
+		Must be called before the area is changed.
+	*/
+
+	if (!this->stroking) return;
+
+	left = std::max(left, 0) / HISTORY_CHUNK_SIZE;
+	top = std::max(top, 0) / HISTORY_CHUNK_SIZE;
+	right = std::min(right, this->width - 1) / HISTORY_CHUNK_SIZE;
+	bottom = std::min(bottom, this->height - 1) / HISTORY_CHUNK_SIZE;
+
+	for (int cy = top; cy <= bottom; cy++) {
+		for (int cx = left; cx <= right; cx++) {
+			int chunk = cy * this->chunkColumns + cx;
+			if (this->touched[chunk]) continue;
+
+			this->touched[chunk] = 1;
+			this->stroke.chunks.push_back({ chunk, this->capture(game, chunk) });
+		}
+	}
+}
+
+void EditHistory::endStroke()
+{
+	if (!this->stroking) return;
+	this->stroking = false;
+
+	for (const ChunkEdit& edit : this->stroke.chunks)
+		this->touched[edit.chunk] = 0;
+
+	if (this->stroke.chunks.empty()) return;
+
+	// A new edit makes the undone strokes unreachable
+	for (const Stroke& undone : this->redoStrokes)
+		this->memoryUsage -= undone.bytes;
+	this->redoStrokes.clear();
+
+	this->stroke.bytes = this->countBytes(this->stroke);
+	this->memoryUsage += this->stroke.bytes;
+	this->undoStrokes.push_back(std::move(this->stroke));
+	this->stroke = Stroke();
+
+	this->trimMemory();
+}
+
+// === Main logic ===
+bool EditHistory::undo(Game& game)
+{
+	/*
+		@return bool - false if there is nothing to undo
+	*/
+
+	this->endStroke();
+	if (this->undoStrokes.empty()) return false;
+
+	Stroke stroke = std::move(this->undoStrokes.back());
+	this->undoStrokes.pop_back();
+	this->memoryUsage -= stroke.bytes;
+
+	this->restore(game, stroke);
+
+	this->memoryUsage += stroke.bytes;
+	this->redoStrokes.push_back(std::move(stroke));
+	this->trimMemory();
+	return true;
+}
+
+bool EditHistory::redo(Game& game)
+{
+	/*
+		@return bool - false if there is nothing to redo
+	*/
+
+	this->endStroke();
+	if (this->redoStrokes.empty()) return false;
+
+	Stroke stroke = std::move(this->redoStrokes.back());
+	this->redoStrokes.pop_back();
+	this->memoryUsage -= stroke.bytes;
+
+	this->restore(game, stroke);
+
+	this->memoryUsage += stroke.bytes;
+	this->undoStrokes.push_back(std::move(stroke));
+	this->trimMemory();
+	return true;
+}
+
+// === Private ===
+std::shared_ptr<const EditHistory::ChunkSnapshot> EditHistory::capture(Game& game, int chunk)
+{
+	/*
+		@return std::shared_ptr<const ChunkSnapshot> - current state of the chunk
+
+		Copies the chunk only if it changed since its last snapshot.
+	*/
+
+	if (!this->changed[chunk] && this->snapshots[chunk])
+		return this->snapshots[chunk];
+
+	auto snapshot = std::make_shared<ChunkSnapshot>();
+	int left = (chunk % this->chunkColumns) * HISTORY_CHUNK_SIZE;
+	int top = (chunk / this->chunkColumns) * HISTORY_CHUNK_SIZE;
+	bool empty = true;
+
+	for (int dy = 0; dy < HISTORY_CHUNK_SIZE; dy++) {
+		for (int dx = 0; dx < HISTORY_CHUNK_SIZE; dx++) {
+			int i = dy * HISTORY_CHUNK_SIZE + dx;
+			int x = left + dx;
+			int y = top + dy;
+
+			// Edge chunks reach past the grid
+			if (x >= this->width || y >= this->height) {
+				snapshot->types[i] = MaterialType::Empty;
+				snapshot->colors[i] = sf::Color::Transparent;
+				continue;
+			}
+
+			const Material* material = game.getRawMaterial(x, y);
+			snapshot->types[i] = material->getType();
+			snapshot->colors[i] = material->getColor();
+			empty = empty && snapshot->types[i] == MaterialType::Empty;
+		}
+	}
+
+	this->snapshots[chunk] = empty ? this->emptySnapshot : snapshot;
+	this->changed[chunk] = 0;
+	return this->snapshots[chunk];
+}
+
+void EditHistory::restore(Game& game, Stroke& stroke)
+{
+	/*
+		@return void
+
+		Writes the saved chunks of a stroke back into the grid and keeps their
+		current state in the stroke instead, so the same call undoes and redoes.
+	*/
+
+	for (ChunkEdit& edit : stroke.chunks) {
+		std::shared_ptr<const ChunkSnapshot> current = this->capture(game, edit.chunk);
+		if (current == edit.snapshot) continue;
+
+		int left = (edit.chunk % this->chunkColumns) * HISTORY_CHUNK_SIZE;
+		int top = (edit.chunk / this->chunkColumns) * HISTORY_CHUNK_SIZE;
+		int right = std::min(left + HISTORY_CHUNK_SIZE, this->width);
+		int bottom = std::min(top + HISTORY_CHUNK_SIZE, this->height);
+
+		for (int y = top; y < bottom; y++) {
+			for (int x = left; x < right; x++) {
+				int i = (y - top) * HISTORY_CHUNK_SIZE + (x - left);
+				MaterialType type = edit.snapshot->types[i];
+
+				if (game.getMaterialType(x, y) != type)
+					game.setMaterialAt(type, x, y);
+				if (type != MaterialType::Empty)
+					game.setColorAt(x, y, edit.snapshot->colors[i]);
+			}
+		}
+
+		// The chunk now matches the restored snapshot
+		this->snapshots[edit.chunk] = edit.snapshot;
+		this->changed[edit.chunk] = 0;
+		edit.snapshot = current;
+	}
+
+	stroke.bytes = this->countBytes(stroke);
+}
+
+std::size_t EditHistory::countBytes(const Stroke& stroke) const
+{
+	std::size_t bytes = sizeof(Stroke) + stroke.chunks.capacity() * sizeof(ChunkEdit);
+	for (const ChunkEdit& edit : stroke.chunks)
+		if (edit.snapshot != this->emptySnapshot)
+			bytes += sizeof(ChunkSnapshot);
+	return bytes;
+}
+
+void EditHistory::trimMemory()
+{
+	/*
+		@return void
+
+		Drops the strokes farthest from the current state until the snapshots fit the
+		budget: the oldest undo steps first, then the redo steps undone first.
+	*/
+
+	while (this->memoryUsage > HISTORY_MEMORY_LIMIT && !this->undoStrokes.empty()) {
+		this->memoryUsage -= this->undoStrokes.front().bytes;
+		this->undoStrokes.pop_front();
+	}
+	while (this->memoryUsage > HISTORY_MEMORY_LIMIT && !this->redoStrokes.empty()) {
+		this->memoryUsage -= this->redoStrokes.front().bytes;
+		this->redoStrokes.pop_front();
+	}
+}
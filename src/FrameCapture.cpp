@@ -0,0 +1,128 @@
+#include "FrameCapture.h"
+
+// Project headers
+#include "Tracer.h"
+
+// STL
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+
+// SFML
+#include <SFML/Graphics.hpp>
+
+// === Constructors ===
+FrameCapture::FrameCapture(const std::string& directory, unsigned encoderThreads, std::size_t queueLimit)
+	: directory(directory),
+	queueLimit(std::max<std::size_t>(queueLimit, 1)),
+	encoders(std::max(encoderThreads, 1u) + 1, "PNG encoder") // the pool keeps one thread for its caller
+{
+	// A bad or unwritable path leaves the capture unusable, isReady() tells the caller
+	std::error_code error;
+	std::filesystem::create_directories(this->directory, error);
+	if (error)
+		this->error = error.message();
+}
+
+FrameCapture::~FrameCapture()
+{
+	this->flush();
+}
+
+// === Accessors ===
+bool FrameCapture::isReady() const
+{
+	return this->error.empty();
+}
+
+const std::string& FrameCapture::getError() const
+{
+	return this->error;
+}
+
+std::size_t FrameCapture::getSavedCount() const
+{
+	std::lock_guard<std::mutex> lock(this->mutex);
+	return this->saved;
+}
+
+std::size_t FrameCapture::getDroppedCount() const
+{
+	std::lock_guard<std::mutex> lock(this->mutex);
+	return this->dropped;
+}
+
+std::size_t FrameCapture::getFailedCount() const
+{
+	std::lock_guard<std::mutex> lock(this->mutex);
+	return this->failed;
+}
+
+// === Methods ===
+std::vector<std::uint8_t>* FrameCapture::acquire(bool wait)
+{
+	/*
+		@return std::vector<std::uint8_t>* - buffer to fill, nullptr if the frame is dropped
+
+		Takes a free frame buffer. Buffers are created on demand up to the queue limit;
+		past it the frame is dropped, or with wait the call blocks until the encoder
+		returns one.
+	*/
+
+	std::unique_lock<std::mutex> lock(this->mutex);
+
+	if (this->freeBuffers.empty() && this->buffers.size() < this->queueLimit) {
+		this->buffers.push_back(std::make_unique<std::vector<std::uint8_t>>());
+		this->freeBuffers.push_back(this->buffers.back().get());
+	}
+
+	if (this->freeBuffers.empty()) {
+		if (!wait) {
+			this->dropped++;
+			return nullptr;
+		}
+		this->bufferReturned.wait(lock, [this] { return !this->freeBuffers.empty(); });
+	}
+
+	std::vector<std::uint8_t>* buffer = this->freeBuffers.back();
+	this->freeBuffers.pop_back();
+	this->inFlight++;
+	return buffer;
+}
+
+void FrameCapture::submit(std::vector<std::uint8_t>* buffer, int frame, unsigned width, unsigned height)
+{
+	this->encoders.submit([this, buffer, frame, width, height] {
+		this->encode(buffer, frame, width, height);
+		});
+}
+
+void FrameCapture::flush()
+{
+	std::unique_lock<std::mutex> lock(this->mutex);
+	this->bufferReturned.wait(lock, [this] { return this->inFlight == 0; });
+}
+
+// === Private ===
+void FrameCapture::encode(std::vector<std::uint8_t>* buffer, int frame, unsigned width, unsigned height)
+{
+	TRACE_SCOPE("PNG encode");
+
+	char name[32];
+	std::snprintf(name, sizeof(name), "frame_%06d.png", frame);
+
+	sf::Image image;
+	image.create(width, height, buffer->data());
+	bool ok = image.saveToFile((std::filesystem::path(this->directory) / name).string());
+
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		if (ok)
+			this->saved++;
+		else
+			this->failed++;
+		this->freeBuffers.push_back(buffer);
+		this->inFlight--;
+	}
+	this->bufferReturned.notify_all();
+}
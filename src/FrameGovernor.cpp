@@ -0,0 +1,98 @@
+#include "FrameGovernor.h"
+
+// === Constructors ===
+FrameGovernor::FrameGovernor() { }
+
+// === Accessors ===
+int FrameGovernor::getLevel() const
+{
+	return this->level;
+}
+
+const char* FrameGovernor::getLevelName() const
+{
+	switch (this->level) {
+		case 0: return "full";
+		case 1: return "gas throttled";
+		case 2: return "short liquid flow";
+		default: return "distant tiles halved";
+	}
+}
+
+float FrameGovernor::getAverageWork() const
+{
+	/*
+		@return float - seconds of work per frame, averaged
+	*/
+
+	return this->averageWork;
+}
+
+bool FrameGovernor::throttlesGas() const
+{
+	return this->level >= 1;
+}
+
+bool FrameGovernor::limitsDispersion() const
+{
+	return this->level >= 2;
+}
+
+bool FrameGovernor::halvesDistantTiles() const
+{
+	return this->level >= 3;
+}
+
+// === Methods ===
+void FrameGovernor::beginFrame(float budget)
+{
+	/*
+		@return void
+
+		Closes the previous frame, adjusts the quality level to its average and starts
+		measuring the new frame. budget is the frame time in seconds.
+
+		A change waits GOVERNOR_SETTLE_FRAMES before the next one, so its effect shows
+		in the average first. Quality drops as soon as the average is over the budget,
+		but only returns after GOVERNOR_RESTORE_FRAMES frames in a row with headroom.
+	*/
+
+	if (this->hasFrame) {
+		this->averageWork += (this->frameWork - this->averageWork) * GOVERNOR_SMOOTHING;
+
+		if (this->settleFrames > 0)
+			this->settleFrames--;
+		else if (this->averageWork > budget * GOVERNOR_PRESSURE && this->level < GOVERNOR_MAX_LEVEL) {
+			this->level++;
+			this->settleFrames = GOVERNOR_SETTLE_FRAMES;
+			this->headroomFrames = 0;
+		}
+		else if (this->averageWork < budget * GOVERNOR_HEADROOM && this->level > 0) {
+			if (++this->headroomFrames >= GOVERNOR_RESTORE_FRAMES) {
+				this->level--;
+				this->settleFrames = GOVERNOR_SETTLE_FRAMES;
+				this->headroomFrames = 0;
+			}
+		}
+		else
+			this->headroomFrames = 0;
+	}
+
+	this->hasFrame = true;
+	this->frameWork = 0.0f;
+	this->beginWork();
+}
+
+void FrameGovernor::beginWork()
+{
+	this->clock.restart();
+	this->measuring = true;
+}
+
+void FrameGovernor::endWork()
+{
+	if (!this->measuring) return;
+
+	this->frameWork += this->clock.getElapsedTime().asSeconds();
+	this->measuring = false;
+}
@@ -0,0 +1,175 @@
+#include "FramePacer.h"
+
+// Project headers
+#include "Tracer.h"
+
+// STL
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+#ifdef _WIN32
+// WinAPI
+#define NOMINMAX
+#include <windows.h>
+#include <timeapi.h>
+#endif
+
+namespace {
+	float toSeconds(std::chrono::steady_clock::duration duration)
+	{
+		return std::chrono::duration<float>(duration).count();
+	}
+
+	// Moving average and mean deviation of a sample, as round-trip time estimators keep them
+	void track(float sample, float& average, float& deviation)
+	{
+		deviation += (std::abs(sample - average) - deviation) * PACER_DEVIATION_SMOOTHING;
+		average += (sample - average) * PACER_SMOOTHING;
+	}
+}
+
+// === Constructors ===
+FramePacer::FramePacer(int rate)
+{
+	this->setTargetRate(rate);
+
+#ifdef _WIN32
+	// The default timer ticks every 15.6 ms, too coarse to sleep through a frame
+	timeBeginPeriod(1);
+#endif
+}
+
+FramePacer::~FramePacer()
+{
+#ifdef _WIN32
+	timeEndPeriod(1);
+#endif
+}
+
+// === Accessors ===
+int FramePacer::getTargetRate() const
+{
+	return this->rate;
+}
+
+void FramePacer::setTargetRate(int rate)
+{
+	this->rate = std::max(rate, 1);
+	this->period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / this->rate));
+	this->started = false;
+}
+
+float FramePacer::getFramePeriod() const
+{
+	/*
+		@return float - seconds between frames at the target rate
+	*/
+
+	return toSeconds(this->period);
+}
+
+float FramePacer::getPredictedCost() const
+{
+	/*
+		@return float - seconds the next frame is expected to take from its start to its present
+	*/
+
+	return this->costAverage + this->costDeviation * PACER_COST_MARGIN;
+}
+
+float FramePacer::getJitter() const
+{
+	/*
+		@return float - seconds the present interval deviates from the frame period, averaged
+	*/
+
+	return this->jitter;
+}
+
+// === Methods ===
+void FramePacer::waitForFrame()
+{
+	/*
+		@return void
+
+		Waits until the predicted cost of a frame before its deadline. A frame that
+		can't make its deadline starts right away, and a late one moves the schedule
+		instead of rushing the frames after it.
+	*/
+
+	TRACE_SCOPE("FramePacer::waitForFrame");
+
+	Clock::time_point now = Clock::now();
+	if (!this->started || now > this->deadline) {
+		this->deadline = now + this->period;
+		this->started = true;
+	}
+
+	float lead = std::min(this->getPredictedCost() + PACER_SAFETY, this->getFramePeriod());
+	Clock::time_point start = this->deadline - std::chrono::duration_cast<Clock::duration>(std::chrono::duration<float>(lead));
+	this->sleepUntil(start);
+
+	this->frameStart = Clock::now();
+	this->waited = true;
+}
+
+void FramePacer::waitForPresent()
+{
+	/*
+		@return void
+
+		Learns the cost of the finished frame and holds it back to its deadline.
+		A frame woken from an idle wait skipped waitForFrame, its start is unknown
+		and its cost is not learned.
+	*/
+
+	TRACE_SCOPE("FramePacer::waitForPresent");
+
+	if (this->waited)
+		track(toSeconds(Clock::now() - this->frameStart), this->costAverage, this->costDeviation);
+	this->waited = false;
+	this->sleepUntil(this->deadline);
+}
+
+void FramePacer::framePresented()
+{
+	/*
+		@return void
+
+		Learns the present interval and moves the deadline one period on
+	*/
+
+	Clock::time_point now = Clock::now();
+
+	// Intervals after a stall or an idle wait say nothing about pacing
+	float interval = toSeconds(now - this->lastPresent);
+	if (interval < 2.0f * this->getFramePeriod())
+		this->jitter += (std::abs(interval - this->getFramePeriod()) - this->jitter) * PACER_SMOOTHING;
+
+	this->lastPresent = now;
+	this->deadline += this->period;
+}
+
+// === Private ===
+void FramePacer::sleepUntil(Clock::time_point time)
+{
+	/*
+		@return void
+
+		Sleeps in 1 ms steps while the remaining time covers a step with its measured
+		overshoot, then spins to the exact time
+	*/
+
+	while (true) {
+		Clock::time_point before = Clock::now();
+		if (toSeconds(time - before) <= this->sleepAverage + this->sleepDeviation * PACER_SLEEP_MARGIN)
+			break;
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		track(toSeconds(Clock::now() - before), this->sleepAverage, this->sleepDeviation);
+	}
+
+	while (Clock::now() < time)
+		std::this_thread::yield();
+}
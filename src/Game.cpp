@@ -1,15 +1,22 @@
 // Project headers
 #include "Game.h"
 #include "Materials.h"
+#include "Tracer.h"
 
 // STL
+#include <algorithm>
+#include <ctime>
+#include <filesystem>
 #include <iostream>
 #include <memory>
 #include <unordered_set>
 #include <sstream>
 
+#ifdef _WIN32
 // WinAPI
+#define NOMINMAX
 #include <windows.h>
+#endif
 
 
 // === GLOBAL RESOLUTION PARAMETERS ===
@@ -32,8 +39,8 @@ UIScaler uiScaler(BASE_RESOLUTION, gameSize);
 
 // === PUBLIC METHODS ===
 // === Constructors ===
-Game::Game()
-	: window(initWindow()),
+Game::Game(bool headless)
+	: window(headless ? nullptr : initWindow()),
 	currentMaterial(MaterialType::Sand),
 	isFullscreen(false),
 	isPaused(false),
@@ -50,10 +57,13 @@ Game::Game()
 	if (!this->icon.loadFromFile("resources/images/icon.png")) exit(EXIT_FAILURE);
 
 	// Window settings
-	this->window->setFramerateLimit(maxFps);
-	this->window->setMouseCursorVisible(false);
-	this->window->setIcon(32, 32, this->icon.getPixelsPtr());
-	this->resizeViewFit();
+	if (this->window) {
+		this->pacer.setTargetRate(maxFps);
+		this->window->setMouseCursorVisible(false);
+		this->window->setIcon(32, 32, this->icon.getPixelsPtr());
+		this->resizeViewFit();
+		this->inputSampler.start(*this->window);
+	}
 
 	// Init text GUI
 	if (!this->defaultFont.loadFromFile("resources/fonts/ByteBounce.ttf")) exit(EXIT_FAILURE);
@@ -110,7 +120,10 @@ Game::Game()
 	this->vertexGrid.resize(gridWidth * gridHeight * 4);
 	this->initVertexGrid();
 
-	this->printTips();
+	this->margolus.setSeed(this->gen());
+
+	if (this->window)
+		this->printTips();
 }
 
 Game::~Game() { }
@@ -118,7 +131,7 @@ Game::~Game() { }
 // === Accessors ===
 const bool Game::running() const
 {
-	return this->window->isOpen();
+	return this->window && this->window->isOpen();
 }
 
 sf::Vector2u Game::getWindowSize() const
@@ -136,6 +149,69 @@ std::mt19937& Game::getRandom()
 	return this->gen;
 }
 
+sf::Vector2f Game::getWindVelocity(int x, int y) const
+{
+	return this->windField.getVelocity(x, y);
+}
+
+MaterialCensus& Game::getCensus()
+{
+	return this->census;
+}
+
+PerfCounters& Game::getPerfCounters()
+{
+	return this->perfCounters;
+}
+
+const OccupancyMap& Game::getOccupancy() const
+{
+	return this->occupancy;
+}
+
+int Game::getDispersionLimit() const
+{
+	/*
+		@return int - cells a liquid may flow sideways this tick, lowered under load
+	*/
+
+	return this->governor.limitsDispersion() ? GOVERNOR_LIQUID_DISPERSION : GRID_HALO;
+}
+
+bool Game::skipsGasUpdate(int x, int y) const
+{
+	/*
+		@return bool - true if the gas at x, y rests this tick
+
+		Under load gases move on alternating ticks in a checkerboard, so half of them move every tick
+	*/
+
+	return this->governor.throttlesGas() && ((x + y + this->tick) & 1);
+}
+
+EngineMode Game::getEngineMode() const
+{
+	return this->engineMode;
+}
+
+void Game::setEngineMode(EngineMode mode)
+{
+	this->engineMode = mode;
+}
+
+void Game::setSeed(std::uint32_t seed)
+{
+	/*
+		@return void
+
+		Seeds the random generator of the material rules and the block automaton,
+		so runs started from the same grid repeat.
+	*/
+
+	this->gen.seed(seed);
+	this->margolus.setSeed(seed);
+}
+
 // === Grid helpers ===
 bool Game::isValidPosition(int x, int y) const
 {
@@ -145,33 +221,117 @@ bool Game::isValidPosition(int x, int y) const
 bool Game::isEmpty(int x, int y) const
 {
 	return isValidPosition(x, y) &&
-		this->grid[y][x]->getType() == MaterialType::Empty;
+		!this->occupancy.isOccupied(x, y);
 }
 
 MaterialType Game::getMaterialType(int x, int y) const
 {
 	if (!this->isValidPosition(x, y))
 		return MaterialType::Empty;
-	return this->grid[y][x]->getType();
+	return this->cell(x, y)->getType();
 }
 
 Material* Game::getRawMaterial(int x, int y)
 {
 	if (!isValidPosition(x, y)) return nullptr;
-	return grid[y][x].get();
+	return this->cell(x, y).get();
 }
 
 void Game::setMaterialAt(MaterialType material, int x, int y)
 {
-	if (this->isValidPosition(x, y))
-		this->grid[y][x] = createMaterial(material, x, y);
+	if (this->isValidPosition(x, y)) {
+		MaterialType previous = this->cell(x, y) ? this->cell(x, y)->getType() : MaterialType::Empty;
+
+		// In gas field mode smoke is added to the concentration field instead of the grid
+		if (this->gasMode && material == MaterialType::Smoke) {
+			this->gasField.add(x, y, 1.0f);
+			material = MaterialType::Empty;
+		}
+
+		this->cell(x, y) = createMaterial(material, x, y);
+		this->occupancy.setMaterial(x, y, material);
+		this->heatField.setMaterial(x, y, material);
+		this->reactions.track(x, y, material);
+		this->windField.replaceMaterial(x, y, previous, material);
+		this->gasField.setOpen(x, y, material == MaterialType::Empty);
+		this->circuit.setMaterial(x, y, material);
+		this->growth.setMaterial(x, y, material);
+		this->rigidBodies.setMaterial(x, y, previous, material);
+		this->census.setMaterial(x, y, previous, material);
+		this->history.markChanged(x, y);
+		this->minimap.markChanged(x, y);
+		this->gridChanged = true;
+	}
+}
+
+void Game::setColorAt(int x, int y, sf::Color color)
+{
+	/*
+		@return void
+
+		Recolors the cell, for restores that keep its material. Only the views of the
+		grid by color care, the material fields do not.
+	*/
+
+	if (!this->isValidPosition(x, y) || this->cell(x, y)->getColor() == color) return;
+
+	this->cell(x, y)->setColor(color);
+	this->history.markChanged(x, y);
+	this->minimap.markChanged(x, y);
+	this->gridChanged = true;
 }
 
 void Game::swapMaterials(int x1, int y1, int x2, int y2)
 {
-	if (this->isValidPosition(x1, y1) &&
-		this->isValidPosition(x2, y2))
-		std::swap(this->grid[y1][x1], this->grid[y2][x2]);
+	/*
+		@return void
+
+		Unchecked, both cells must be inside the grid. The material rules only swap
+		with cells that are not border sentinels, so they are.
+	*/
+
+	std::swap(this->cell(x1, y1), this->cell(x2, y2));
+	this->occupancy.swapCells(x1, y1, x2, y2);
+	this->heatField.swapCells(x1, y1, x2, y2);
+	this->gasField.swapCells(x1, y1, x2, y2);
+	this->reactions.track(x1, y1, this->cell(x1, y1)->getType());
+	this->reactions.track(x2, y2, this->cell(x2, y2)->getType());
+	this->growth.moveMaterial(x1, y1, this->cell(x1, y1)->getType());
+	this->growth.moveMaterial(x2, y2, this->cell(x2, y2)->getType());
+	this->rigidBodies.swapCells(x1, y1, x2, y2, this->cell(x1, y1)->getType(), this->cell(x2, y2)->getType());
+	this->census.swapCells(x1, y1, x2, y2, this->cell(x1, y1)->getType(), this->cell(x2, y2)->getType());
+	this->history.markChanged(x1, y1);
+	this->history.markChanged(x2, y2);
+	this->minimap.markChanged(x1, y1);
+	this->minimap.markChanged(x2, y2);
+	this->gridChanged = true;
+}
+
+void Game::shiftColumnDown(int x, int top, int bottom)
+{
+	/*
+		@return void
+
+		Moves the solid cells top..bottom of column x one cell down into the empty (or,
+		for falling structures, passable) cell below them, that cell ends up at the top.
+	*/
+
+	std::unique_ptr<Material> below = std::move(this->cell(x, bottom + 1));
+	for (int y = bottom + 1; y > top; y--)
+		this->cell(x, y) = std::move(this->cell(x, y - 1));
+	this->cell(x, top) = std::move(below);
+
+	// Inside the run nothing changes for the bitmaps and the gas mask, only the ends swap
+	this->occupancy.swapCells(x, top, x, bottom + 1);
+	this->gasField.swapCells(x, top, x, bottom + 1);
+	this->heatField.shiftColumnDown(x, top, bottom);
+	this->history.markColumnChanged(x, top, bottom + 1);
+	this->minimap.markColumnChanged(x, top, bottom + 1);
+	for (int y = top; y <= bottom + 1; y++)
+		this->reactions.track(x, y, this->cell(x, y)->getType());
+	this->growth.moveMaterial(x, top, this->cell(x, top)->getType());
+	this->rigidBodies.shiftColumnDown(x, top);
+	this->census.shiftColumnDown(*this, x, top, bottom);
 }
 
 // === Main logic ===
@@ -181,65 +341,327 @@ void Game::update()
 		@return void
 
 		- event processing
-		- update grid
+		- update grid (material rules or block automaton)
+		- update reactions
+		- update heat (every HEAT_UPDATE_INTERVAL ticks)
+		- update wind (every WIND_UPDATE_INTERVAL ticks)
+		- update gas field (gas field mode only)
+		- update circuits
+		- update plant growth
+		- update falling structures
 		- update vertex colors
+		- update minimap
+		- record replay tick
 		- update selected material text
 		- update FPS
+		- detect an idle scene
 
 		Updates game objects per frame.
+		In a window the frame governor measures the work and lowers the quality under load.
 	*/
 
-	this->handleEvents();
+	TRACE_SCOPE("Game::update");
+
+	// A headless game is driven by its runner, there is no input
+	bool input = false;
+	if (this->window) {
+		// Input is read after the wait for the frame slot, as close as possible to the frame that shows it
+		if (!this->idle)
+			this->pacer.waitForFrame();
+		input = this->handleEvents();
+		this->governor.beginFrame(this->pacer.getFramePeriod());
+	}
+
+	// Replay playback replaces the simulation
+	if (this->replayPlayer) {
+		this->updateReplay();
+		if (showFps)
+			this->updateFPS();
+		this->governor.endWork();
+		return;
+	}
+
+	this->perfCounters.beginTick();
 
 	if (!isPaused) {
-		// Reset the update checkboxes
-		for (int y = 0; y < gridHeight; y++)
-			for (int x = 0; x < gridWidth; x++)
-				grid[y][x]->setUpdated(false);
-
-		// Change the update direction left/right every frame
-		static bool leftToRight = true;
-		leftToRight = !leftToRight;
-
-		// Updating the grid from the bottom up
-		for (int y = gridHeight - 1; y >= 0; y--) {
-			if (leftToRight) {
-				for (int x = 0; x < gridWidth; x++) {
-					if (grid[y][x]->isUpdated() ||
-						grid[y][x]->getType() == MaterialType::Empty)
-						continue;
-
-					grid[y][x]->setUpdated(true);
-					grid[y][x]->update(x, y, *this);
-				}
-			}
-			else {
-				for (int x = gridWidth - 1; x >= 0; x--) {
-					if (grid[y][x]->isUpdated() ||
-						grid[y][x]->getType() == MaterialType::Empty)
-						continue;
+		{
+			TRACE_SCOPE("Grid update");
+			this->perfCounters.beginRegion();
 
-					grid[y][x]->setUpdated(true);
-					grid[y][x]->update(x, y, *this);
+			if (this->engineMode == EngineMode::Margolus)
+				this->margolus.step(*this, this->threadPool, this->tick);
+			else {
+				// Reset the update checkboxes, only cells with an update rule ever set them
+				for (int y = 0; y < gridHeight; y++)
+					for (int x = this->occupancy.nextMovable(0, y); x < gridWidth; x = this->occupancy.nextMovable(x + 1, y))
+						this->cell(x, y)->setUpdated(false);
+
+				// Change the update direction left/right every frame
+				static bool leftToRight = true;
+				leftToRight = !leftToRight;
+
+				// Updating the grid band by band of tile rows from the bottom up, every row of
+				// a band from the bottom up and across its tiles in the sweep direction, so the
+				// order stays strictly bottom up across tile seams while the neighbors probed
+				// stay in the band just visited.
+				// The scan jumps between cells that have an update rule and re-reads the
+				// bitmap after every step, so cells moved by an update are seen right away
+				int tileColumns = this->grid.getTileColumns();
+
+				// Under load, tiles away from the brush take turns in a checkerboard and each runs every other tick
+				bool halveDistant = this->governor.halvesDistantTiles();
+				sf::Vector2i focus = halveDistant ? this->getMousePosition() / cellSize : sf::Vector2i();
+
+				for (int tileY = this->grid.getTileRows() - 1; tileY >= 0; tileY--) {
+					int top = tileY * CELL_TILE_SIZE;
+					int bottom = std::min(top + CELL_TILE_SIZE, gridHeight) - 1;
+
+					for (int y = bottom; y >= top; y--) {
+						if (!this->occupancy.hasMovable(y))
+							continue;
+
+						for (int column = 0; column < tileColumns; column++) {
+							int tileX = leftToRight ? column : tileColumns - 1 - column;
+							int left = tileX * CELL_TILE_SIZE;
+							int right = std::min(left + CELL_TILE_SIZE, gridWidth) - 1;
+
+							if (halveDistant && ((tileX + tileY + this->tick) & 1) &&
+								std::max({ left - focus.x, focus.x - right, top - focus.y, focus.y - bottom }) > GOVERNOR_FOCUS_RADIUS)
+								continue;
+
+							if (leftToRight) {
+								for (int x = this->occupancy.nextMovable(left, y); x <= right; x = this->occupancy.nextMovable(x + 1, y)) {
+									if (this->cell(x, y)->isUpdated() || this->tryColumnFall(x, y))
+										continue;
+
+									this->cell(x, y)->setUpdated(true);
+									this->cell(x, y)->update(x, y, *this);
+								}
+							}
+							else {
+								for (int x = this->occupancy.previousMovable(right, y); x >= left; x = this->occupancy.previousMovable(x - 1, y)) {
+									if (this->cell(x, y)->isUpdated() || this->tryColumnFall(x, y))
+										continue;
+
+									this->cell(x, y)->setUpdated(true);
+									this->cell(x, y)->update(x, y, *this);
+								}
+							}
+						}
+					}
 				}
 			}
+
+			this->perfCounters.endRegion(PerfRegion::GridUpdate);
 		}
+
+		this->reactions.update(*this);
+
+		// Heat runs at a lower tick rate than movement to keep its cost bounded
+		if (++this->tick % HEAT_UPDATE_INTERVAL == 0)
+			this->updateHeat();
+
+		if (this->tick % WIND_UPDATE_INTERVAL == 0)
+			this->windField.step(this->threadPool, this->heatField);
+
+		if (this->gasMode && !(this->governor.throttlesGas() && this->tick % 2))
+			this->gasField.step(this->threadPool);
+
+		this->circuit.update();
+		this->growth.update(*this);
+		this->rigidBodies.update(*this);
 	}
 
+	this->perfCounters.beginRegion();
 	this->updateVertexColors();
+	this->perfCounters.endRegion(PerfRegion::ColorBuild);
+
+	if (this->window) {
+		// Keep the last seconds for rewinding. The chunks the minimap saw change,
+		// painting while paused included, stay pending until a tick packs them;
+		// the encoding runs on a background thread, a tick it can't take is dropped
+		this->rewind.markChanged(this->minimap.getDirtyChunks());
+		if (!this->isPaused) {
+			TRACE_SCOPE("Rewind pack");
+			if (RewindFrame* frame = this->rewind.acquire()) {
+				this->packChunks(*frame);
+				this->rewind.submit(frame);
+				this->rewindTick = this->rewind.getLastTick();
+			}
+		}
+
+		// Only the chunks changed since the last frame are summarized again
+		this->minimap.update(this->vertexGrid);
+	}
+
+	// Every frame is recorded, so painting while paused is kept as well
+	if (this->recorder.isRecording()) {
+		this->packCells(this->recordedCells);
+		this->recorder.record(this->recordedCells);
+	}
 
 	// Update UI
 	std::ostringstream ss;
 	ss.precision(1);
 	ss << std::fixed << this->brushSolidity;
 
-	this->brushInfoText.setString("Brush: Size: " + std::to_string(this->brushSize) + " Solidity: " + ss.str());
+	std::string brushInfo = "Brush: Size: " + std::to_string(this->brushSize) + " Solidity: " + ss.str();
+
+	// Census of the selected material, in the grid and under the brush
+	if (this->window) {
+		sf::Vector2i mousePos = this->getMousePosition();
+		int centerX = mousePos.x / cellSize;
+		int centerY = mousePos.y / cellSize;
+		std::size_t underBrush = this->census.countInRegion(*this, this->currentMaterial,
+			centerX - this->brushSize, centerY - this->brushSize, centerX + this->brushSize, centerY + this->brushSize);
+
+		brushInfo += "  " + getMaterialInfo(this->currentMaterial).name + ": " +
+			std::to_string(this->census.getCount(this->currentMaterial)) + " (brush: " + std::to_string(underBrush) + ")";
+	}
+	this->brushInfoText.setString(brushInfo);
 
 	if (showFps)
 		this->updateFPS();
 
 	if (this->messageClock.getElapsedTime().asSeconds() > this->messageDuration)
 		this->showMessage = false;
+
+	// Nothing moved, nothing is left to settle and nobody touched the game: the next
+	// frame waits for input instead of simulating and drawing the same picture again.
+	// The minimap fades its active chunks first, or it would show them as active while asleep
+	this->idle = this->window && !input && !this->gridChanged && (this->isPaused || this->isSimulationIdle())
+		&& this->minimap.getActiveCount() == 0
+		&& !this->showMessage && !this->showFps && !this->recorder.isRecording();
+	this->gridChanged = false;
+
+	this->governor.endWork();
+}
+
+void Game::copyFrame(std::vector<std::uint8_t>& pixels) const
+{
+	/*
+		@return void
+
+		Copies the colors of the last update into an RGBA image with one pixel per cell.
+	*/
+
+	pixels.resize(static_cast<std::size_t>(gridWidth) * gridHeight * 4);
+
+	for (int i = 0; i < gridWidth * gridHeight; i++) {
+		const sf::Color& color = this->vertexGrid[i * 4].color;
+		pixels[i * 4 + 0] = color.r;
+		pixels[i * 4 + 1] = color.g;
+		pixels[i * 4 + 2] = color.b;
+		pixels[i * 4 + 3] = 255;
+	}
+}
+
+void Game::packCells(std::vector<std::uint32_t>& cells) const
+{
+	/*
+		@return void
+
+		Packs every cell as 0xIIRRGGBB, the material index and the displayed color
+	*/
+
+	cells.resize(static_cast<std::size_t>(gridWidth) * gridHeight);
+
+	for (int y = 0; y < gridHeight; y++) {
+		for (int x = 0; x < gridWidth; x++) {
+			int i = x + y * gridWidth;
+			const sf::Color& color = this->vertexGrid[i * 4].color;
+			cells[i] = (static_cast<std::uint32_t>(materialIndex(this->cell(x, y)->getType())) << 24) |
+				(color.r << 16) | (color.g << 8) | color.b;
+		}
+	}
+}
+
+
+void Game::packChunks(RewindFrame& frame) const
+{
+	/*
+		@return void
+
+		Packs the cells of the frame's chunks as 0xIIRRGGBB, the material index and
+		the material's own color without overlays, so restoreState can rebuild the
+		grid from the decoded ticks
+	*/
+
+	static_assert(REWIND_CHUNK_SIZE == MINIMAP_CHUNK_SIZE, "the rewind buffer reuses the minimap change marks");
+
+	frame.cells.resize(frame.chunks.size() * REWIND_CHUNK_SIZE * REWIND_CHUNK_SIZE);
+	std::uint32_t* out = frame.cells.data();
+	int columns = this->minimap.getColumns();
+
+	for (int chunk : frame.chunks) {
+		int left = (chunk % columns) * REWIND_CHUNK_SIZE;
+		int top = (chunk / columns) * REWIND_CHUNK_SIZE;
+		int right = std::min(left + REWIND_CHUNK_SIZE, gridWidth);
+		int bottom = std::min(top + REWIND_CHUNK_SIZE, gridHeight);
+
+		for (int y = top; y < bottom; y++) {
+			std::uint32_t* row = out + (y - top) * REWIND_CHUNK_SIZE;
+			for (int x = left; x < right; x++) {
+				const Material& material = *this->cell(x, y);
+				sf::Color color = material.getColor();
+				row[x - left] = (static_cast<std::uint32_t>(materialIndex(material.getType())) << 24) |
+					(color.r << 16) | (color.g << 8) | color.b;
+			}
+		}
+		out += REWIND_CHUNK_SIZE * REWIND_CHUNK_SIZE;
+	}
+}
+
+void Game::restoreState(const std::vector<std::uint32_t>& cells)
+{
+	/*
+		@return void
+
+		Rebuilds the grid from a decoded rewind tick. Only cells of another material are
+		recreated, the rest just take the saved color.
+	*/
+
+	for (int y = 0; y < gridHeight; y++) {
+		for (int x = 0; x < gridWidth; x++) {
+			std::uint32_t cell = cells[x + y * gridWidth];
+			MaterialType type = getMaterialInfoByIndex(cell >> 24).type;
+
+			if (this->cell(x, y)->getType() != type)
+				this->setMaterialAt(type, x, y);
+			if (type != MaterialType::Empty)
+				this->setColorAt(x, y, sf::Color((cell >> 16) & 0xFF, (cell >> 8) & 0xFF, cell & 0xFF));
+		}
+	}
+}
+
+
+// === Replays ===
+bool Game::loadReplay(const std::string& path)
+{
+	/*
+		@return bool - false if the file is not a readable replay
+
+		Switches the game into playback of a replay file. The grid takes the recorded
+		size and the cell size is fitted to the game area.
+	*/
+
+	auto player = std::make_unique<ReplayPlayer>();
+	if (!player->open(path)) return false;
+
+	this->recorder.close();
+
+	gridWidth = player->getWidth();
+	gridHeight = player->getHeight();
+	cellSize = std::max(std::min(static_cast<int>(gameSize.x) / gridWidth, static_cast<int>(gameSize.y) / gridHeight), 1);
+	this->vertexGrid.resize(gridWidth * gridHeight * 4);
+	this->initVertexGrid();
+
+	this->replayPlayer = std::move(player);
+	this->replaySpeed = 1;
+	this->replayPaused = false;
+	this->updateReplay();
+
+	return true;
 }
 
 void Game::render()
@@ -254,8 +676,12 @@ void Game::render()
 		Renders the game objects.
 	*/
 
+	TRACE_SCOPE("Game::render");
+
 	this->window->clear(sf::Color::Black);
 
+	this->governor.beginWork();
+
 	// Draw game objects
 	// Draw vertex grid
 	this->window->draw(this->vertexGrid);
@@ -263,6 +689,10 @@ void Game::render()
 	// Draw a pen
 	drawPen();
 
+	// Draw the overview map, a replay only has its recorded colors
+	if (!this->replayPlayer)
+		this->minimap.draw(*this->window);
+
 	// Draw UI
 	this->window->draw(this->selectedMaterialText);
 
@@ -277,7 +707,11 @@ void Game::render()
 	if (showMessage)
 		this->window->draw(this->messageText);
 
+	// The frame is held back to its deadline, that wait is headroom and not work
+	this->governor.endWork();
+	this->pacer.waitForPresent();
 	this->window->display();
+	this->pacer.framePresented();
 }
 
 // === PRIVATE METHODS ===
@@ -291,14 +725,55 @@ std::unique_ptr<sf::RenderWindow> Game::initWindow()
 	);
 }
 
+void Game::fillBorder()
+{
+	/*
+		@return void
+
+		Fills the cells around the grid with sentinels of the border mode: Wall stops
+		every move, Void deletes whatever moves into it.
+	*/
+
+	MaterialType border = this->hasBorders ? MaterialType::Wall : MaterialType::Void;
+
+	for (int y = -GRID_HALO; y < gridHeight + GRID_HALO; y++) {
+		bool inside = y >= 0 && y < gridHeight;
+
+		for (int x = -GRID_HALO; x < gridWidth + GRID_HALO; x++) {
+			if (inside && x == 0)
+				x = gridWidth;
+			this->cell(x, y) = std::make_unique<BorderMaterial>(border);
+		}
+	}
+}
+
 void Game::initVertexGrid() {
+	// A replay keeps one grid size for its whole length
+	if (this->recorder.isRecording())
+		this->toggleRecording();
+
 	// Fill the grid cells with Empty material
-	this->grid.resize(gridHeight);
-	for (int y = 0; y < gridHeight; y++) {
-		this->grid[y].resize(gridWidth);
+	this->occupancy.resize(gridWidth, gridHeight);
+	this->heatField.resize(gridWidth, gridHeight);
+	this->reactions.resize(gridWidth, gridHeight);
+	this->windField.resize(gridWidth, gridHeight);
+	this->gasField.resize(gridWidth, gridHeight);
+	this->circuit.resize(gridWidth, gridHeight);
+	this->growth.resize(gridWidth, gridHeight);
+	this->rigidBodies.resize(gridWidth, gridHeight);
+	this->history.resize(gridWidth, gridHeight);
+	this->census.resize(gridWidth, gridHeight);
+	this->rewind.resize(gridWidth, gridHeight);
+	this->rewindTick = -1;
+	this->grid.resize(gridWidth, gridHeight);
+	this->fillBorder();
+	this->minimap.resize(gridWidth, gridHeight);
+	this->minimap.place(uiScaler.scalePosition(sf::Vector2f(BASE_RESOLUTION.x - 10 - MINIMAP_WIDTH, 10)),
+		uiScaler.scaleSize(sf::Vector2f(MINIMAP_WIDTH, 0)).x);
+
+	for (int y = 0; y < gridHeight; y++)
 		for (int x = 0; x < gridWidth; x++)
 			this->setMaterialAt(MaterialType::Empty, x, y);
-	}
 
 	// Create the vertex grid
 	for (int y = 0; y < gridHeight; y++) {
@@ -319,21 +794,28 @@ void Game::initVertexGrid() {
 
 
 // === Update Methods ===
-void Game::handleEvents()
+bool Game::handleEvents()
 {
 	/*
-		@return void
+		@return bool - true if there was input, an event or a mouse button held down
 
 		- handle window input
 		- handle keyboard input
 		- handle mouse input
 
-		Handles events
+		Handles events. An idle game blocks here until the next event arrives.
 	*/
 
+	TRACE_SCOPE("Events");
+
+	bool input = false;
+
 	// Event polling
-	while (this->window->pollEvent(this->event))
+	while (this->idle ? this->window->waitEvent(this->event) : this->window->pollEvent(this->event))
 	{
+		this->idle = false;
+		input = true;
+
 		// Handle window input
 		if (event.type == sf::Event::Closed) {
 			this->clearConsoleRow();
@@ -344,7 +826,16 @@ void Game::handleEvents()
 		if (event.type == sf::Event::Resized)
 			updateView(this->windowMode);
 
+		// Handle mouse input, the sampler follows the button until it is released
+		if (event.type == sf::Event::MouseButtonPressed && !this->replayPlayer)
+			this->inputSampler.press({ this->event.mouseButton.x, this->event.mouseButton.y }, this->event.mouseButton.button);
+
 		// Handle keyboard input
+		if (event.type == sf::Event::KeyPressed && this->replayPlayer) {
+			this->handleReplayKey(this->event.key.code);
+			continue;
+		}
+
 		if (event.type == sf::Event::KeyPressed) {
 			switch (this->event.key.code) {
 			case sf::Keyboard::Num1:
@@ -389,6 +880,24 @@ void Game::handleEvents()
 				this->clearConsoleRow();
 				std::cout << "Smoke SELECTED";
 				break;
+			case sf::Keyboard::Num8:
+				this->currentMaterial = MaterialType::Lava;
+				this->updateSelectedMaterialText();
+				this->clearConsoleRow();
+				std::cout << "Lava SELECTED";
+				break;
+			case sf::Keyboard::Num9:
+				this->currentMaterial = MaterialType::Fire;
+				this->updateSelectedMaterialText();
+				this->clearConsoleRow();
+				std::cout << "Fire SELECTED";
+				break;
+			case sf::Keyboard::Num0:
+				this->currentMaterial = MaterialType::Vent;
+				this->updateSelectedMaterialText();
+				this->clearConsoleRow();
+				std::cout << "Vent SELECTED";
+				break;
 			case sf::Keyboard::Equal:
 				this->brushSize = std::min(this->brushSize + 1, 25);
 				this->clearConsoleRow();
@@ -409,16 +918,68 @@ void Game::handleEvents()
 				this->clearConsoleRow();
 				std::cout << "Brush Solidity: " << this->brushSolidity;
 				break;
+			case sf::Keyboard::W:
+				this->currentMaterial = MaterialType::Wire;
+				this->updateSelectedMaterialText();
+				this->clearConsoleRow();
+				std::cout << "Wire SELECTED";
+				break;
+			case sf::Keyboard::E:
+				this->currentMaterial = MaterialType::Battery;
+				this->updateSelectedMaterialText();
+				this->clearConsoleRow();
+				std::cout << "Battery SELECTED";
+				break;
+			case sf::Keyboard::N:
+				this->currentMaterial = MaterialType::Inverter;
+				this->updateSelectedMaterialText();
+				this->clearConsoleRow();
+				std::cout << "Inverter SELECTED";
+				break;
+			case sf::Keyboard::L:
+				this->currentMaterial = MaterialType::Plant;
+				this->updateSelectedMaterialText();
+				this->clearConsoleRow();
+				std::cout << "Plant SELECTED";
+				break;
+			case sf::Keyboard::R:
+				this->toggleRecording();
+				break;
+			case sf::Keyboard::F12:
+				this->toggleTracing();
+				break;
 			case sf::Keyboard::C:
+				// Unchanged and empty chunks share their snapshots, so this costs little
+				this->history.beginStroke();
+				this->history.touchArea(*this, 0, 0, gridWidth - 1, gridHeight - 1);
+
+				// Drop the circuit in one go instead of unwiring it cell by cell
+				this->circuit.resize(gridWidth, gridHeight);
 				for (int y = 0; y < gridHeight; y++)
 					for (int x = 0; x < gridWidth; x++)
-						this->grid[y][x] = std::make_unique<EmptyMaterial>();
+						this->setMaterialAt(MaterialType::Empty, x, y);
+				this->history.endStroke();
 				this->showTemporaryMessage("Area cleared");
 				this->clearConsoleRow();
 				std::cout << "Area CLEARED";
 				break;
+			case sf::Keyboard::M: {
+					bool margolusMode = this->engineMode == EngineMode::Classic;
+					this->setEngineMode(margolusMode ? EngineMode::Margolus : EngineMode::Classic);
+					this->showTemporaryMessage(margolusMode ? "Block automaton engine selected" : "Classic engine selected");
+					this->clearConsoleRow();
+					std::cout << (margolusMode ? "Block automaton engine SELECTED" : "Classic engine SELECTED");
+					break;
+				}
+			case sf::Keyboard::G:
+				this->setGasMode(!this->gasMode);
+				this->showTemporaryMessage(gasMode ? "Gas field mode enabled" : "Gas field mode disabled");
+				this->clearConsoleRow();
+				std::cout << (gasMode ? "Gas field mode ENABLED" : "Gas field mode DISABLED");
+				break;
 			case sf::Keyboard::B:
 				this->hasBorders = !this->hasBorders;
+				this->fillBorder();
 				this->showTemporaryMessage(hasBorders ? "Borders are enabled" : "Borders are disabled");
 				this->clearConsoleRow();
 				std::cout << (hasBorders ? "Borders are ENABLED" : "Borders are DISABLED");
@@ -456,10 +1017,16 @@ void Game::handleEvents()
 				break;
 			case sf::Keyboard::Pause:
 				this->isPaused = !this->isPaused;
+
+				// Resuming from a rewound tick drops the ticks after it
+				if (!this->isPaused && this->rewindTick < this->rewind.getLastTick())
+					this->rewind.truncate(this->rewindTick);
 				this->clearConsoleRow();
 				std::cout << (isPaused ? "Game PAUSED" : "Game RESUMED");
 				break;
 			case sf::Keyboard::F11:
+				// The sampler thread reads the mouse relative to the window, it must not see it rebuilt
+				this->inputSampler.stop();
 				isFullscreen = !isFullscreen;
 				if (isFullscreen) {
 					this->window->create(sf::VideoMode::getDesktopMode(), WINDOW_TITLE, sf::Style::Fullscreen);
@@ -469,9 +1036,9 @@ void Game::handleEvents()
 					this->window->create(sf::VideoMode(windowWidth, windowHeight), WINDOW_TITLE, sf::Style::Default);
 					updateView(this->windowMode);
 				}
-				this->window->setFramerateLimit(maxFps);
 				this->window->setMouseCursorVisible(false);
 				this->window->setIcon(32, 32, this->icon.getPixelsPtr());
+				this->inputSampler.start(*this->window);
 				break;
 			case sf::Keyboard::Escape:
 				this->clearConsoleRow();
@@ -494,16 +1061,283 @@ void Game::handleEvents()
 				this->vertexGrid.resize(gridWidth * gridHeight * 4);
 				this->initVertexGrid();
 				break;
+			case sf::Keyboard::LBracket:
+			case sf::Keyboard::RBracket: {
+				int step = this->event.key.shift ? REWIND_SCRUB_STEP : 1;
+				this->scrubRewind(this->event.key.code == sf::Keyboard::LBracket ? -step : step);
+				break;
+			}
+			case sf::Keyboard::Z:
+				if (this->event.key.control) {
+					bool undone = this->history.undo(*this);
+					this->showTemporaryMessage(undone ? "Undo" : "Nothing to undo");
+					this->clearConsoleRow();
+					std::cout << (undone ? "Undo" : "Nothing to undo");
+					break;
+				}
+				[[fallthrough]];
+			case sf::Keyboard::Y:
+				if (this->event.key.control) {
+					bool redone = this->history.redo(*this);
+					this->showTemporaryMessage(redone ? "Redo" : "Nothing to redo");
+					this->clearConsoleRow();
+					std::cout << (redone ? "Redo" : "Nothing to redo");
+					break;
+				}
+				[[fallthrough]];
+			default:
+				// Keys of materials from the definitions file
+				if (this->event.key.code >= sf::Keyboard::A && this->event.key.code <= sf::Keyboard::Z) {
+					char key = static_cast<char>('A' + (this->event.key.code - sf::Keyboard::A));
+					if (const MaterialDefinition* definition = findMaterialDefinitionByKey(key)) {
+						this->currentMaterial = definition->type;
+						this->updateSelectedMaterialText();
+						this->clearConsoleRow();
+						std::cout << definition->name << " SELECTED";
+					}
+				}
+				break;
 			}
 		}
 	}
 
-	// Handle mouse input
-	if (sf::Mouse::isButtonPressed(sf::Mouse::Left))
-		spawnMaterial();
+	// Paint along every mouse sample taken since the last frame
+	this->inputSampler.poll();
+	this->inputSampler.drain(this->inputSamples);
+	if (this->replayPlayer)
+		return input;
+
+	for (const InputSample& sample : this->inputSamples)
+		this->paintSample(sample);
+
+	return input || this->history.isStroking();
+}
+
+bool Game::isSimulationIdle() const
+{
+	/*
+		@return bool - true if no subsystem has work left that could change the grid
+	*/
+
+	return this->heatField.isIdle() && this->reactions.isIdle() && this->circuit.isIdle()
+		&& this->growth.isIdle() && this->rigidBodies.isIdle() && (!this->gasMode || this->gasField.isIdle());
+}
+
+bool Game::tryColumnFall(int x, int y)
+{
+	/*
+		@return bool - true if the cell was moved
+
+		Fast path for free fall. A solid movable with an empty cell below would only step
+		down, and so would every grain stacked on it, so the whole run moves in one block
+		without evaluating the per-cell rules.
+	*/
+
+	auto isSolidMovable = [&](int cx, int cy) -> bool {
+		return static_cast<MaterialState>(static_cast<uint16_t>(this->cell(cx, cy)->getType()) & (STATE_MASK | SOLID_TYPE_BIT)) == MaterialState::SolidMovable;
+		};
+
+	if (y + 1 >= gridHeight || this->occupancy.isOccupied(x, y + 1) || !isSolidMovable(x, y))
+		return false;
+
+	int top = y;
+	while (top > 0 && isSolidMovable(x, top - 1) && !this->cell(x, top - 1)->isUpdated())
+		top--;
+
+	this->shiftColumnDown(x, top, y);
+	for (int cy = top + 1; cy <= y + 1; cy++)
+		this->cell(x, cy)->setUpdated(true);
+
+	return true;
+}
+
+void Game::updateHeat()
+{
+	/*
+		@return void
+
+		Advances the heat field and resolves phase transitions through the material table
+	*/
+
+	TRACE_SCOPE("Heat");
+
+	for (int i : this->heatField.step(this->threadPool)) {
+		int x = i % gridWidth;
+		int y = i / gridWidth;
+
+		float temperature = this->heatField.getTemperature(x, y);
+		const PhaseTransition& phase = getMaterialInfo(this->getMaterialType(x, y)).phase;
+
+		MaterialType product = temperature < phase.lowTemperature ? phase.lowProduct : phase.highProduct;
+		this->setMaterialAt(product, x, y);
+
+		// The new phase keeps the heat of the old one
+		this->heatField.setTemperature(x, y, temperature);
+	}
+}
+
+void Game::updateReplay()
+{
+	/*
+		@return void
+
+		Advances playback and copies the colors of the current tick into the vertex grid
+	*/
+
+	TRACE_SCOPE("Replay playback");
+
+	if (!this->replayPaused)
+		this->replayPlayer->advance(this->replaySpeed);
+
+	const std::vector<std::uint32_t>& cells = this->replayPlayer->getCells();
+	for (std::size_t i = 0; i < cells.size(); i++) {
+		sf::Color color((cells[i] >> 16) & 0xFF, (cells[i] >> 8) & 0xFF, cells[i] & 0xFF);
+		sf::Vertex* quad = &this->vertexGrid[i * 4];
+		for (int j = 0; j < 4; j++)
+			quad[j].color = color;
+	}
+
+	this->selectedMaterialText.setString("Replay " + std::to_string(this->replayPlayer->getTick() + 1) + "/" +
+		std::to_string(this->replayPlayer->getTickCount()) + " x" + std::to_string(this->replaySpeed) +
+		(this->replayPaused ? " paused" : ""));
+}
+
+void Game::handleReplayKey(sf::Keyboard::Key key)
+{
+	/*
+		@return void
+
+		Playback controls: Space pauses, Left/Right seek, Up/Down change the speed,
+		Home restarts. A negative speed plays backwards.
+	*/
+
+	int tick = this->replayPlayer->getTick();
+
+	switch (key) {
+	case sf::Keyboard::Space:
+	case sf::Keyboard::Pause:
+		this->replayPaused = !this->replayPaused;
+		break;
+	case sf::Keyboard::Right:
+		this->replayPlayer->seek(tick + REPLAY_SEEK_TICKS);
+		break;
+	case sf::Keyboard::Left:
+		this->replayPlayer->seek(tick - REPLAY_SEEK_TICKS);
+		break;
+	case sf::Keyboard::Up:
+		if (this->replaySpeed == -1) this->replaySpeed = 1;
+		else if (this->replaySpeed < 0) this->replaySpeed /= 2;
+		else this->replaySpeed = std::min(this->replaySpeed * 2, REPLAY_MAX_SPEED);
+		break;
+	case sf::Keyboard::Down:
+		if (this->replaySpeed == 1) this->replaySpeed = -1;
+		else if (this->replaySpeed > 0) this->replaySpeed /= 2;
+		else this->replaySpeed = std::max(this->replaySpeed * 2, -REPLAY_MAX_SPEED);
+		break;
+	case sf::Keyboard::Home:
+		this->replayPlayer->seek(0);
+		break;
+	case sf::Keyboard::Escape:
+		this->clearConsoleRow();
+		std::cout << "Replay CLOSED";
+		this->window->close();
+		break;
+	default:
+		break;
+	}
+}
+
+void Game::toggleRecording()
+{
+	/*
+		@return void
+
+		Starts recording into replays/ with a timestamped name, or finishes the current recording
+	*/
+
+	if (this->recorder.isRecording()) {
+		this->recorder.close();
+		this->showTemporaryMessage("Replay saved");
+		this->clearConsoleRow();
+		std::cout << "Replay saved: " << this->recorder.getPath() << " (" << this->recorder.getTickCount() << " ticks, "
+			<< this->recorder.getByteCount() / 1024 << " KB)";
+		return;
+	}
+
+	char name[64];
+	std::time_t now = std::time(nullptr);
+	std::strftime(name, sizeof(name), "replays/replay_%Y%m%d_%H%M%S.sbr", std::localtime(&now));
+
+	std::error_code error;
+	std::filesystem::create_directories("replays", error);
+
+	if (!this->recorder.open(name, gridWidth, gridHeight)) {
+		this->showTemporaryMessage("Replay could not be created");
+		this->clearConsoleRow();
+		std::cout << "Failed to create " << name;
+		return;
+	}
+
+	this->showTemporaryMessage("Recording replay");
+	this->clearConsoleRow();
+	std::cout << "Recording replay: " << name;
+}
+
+void Game::toggleTracing()
+{
+	/*
+		@return void
+
+		Starts a timeline trace, or stops it and writes it into traces/ with a timestamped name
+	*/
+
+	if (!Tracer::isEnabled()) {
+		Tracer::start();
+		this->showTemporaryMessage("Tracing started");
+		this->clearConsoleRow();
+		std::cout << "Tracing STARTED";
+		return;
+	}
+
+	Tracer::stop();
+
+	char name[64];
+	std::time_t now = std::time(nullptr);
+	std::strftime(name, sizeof(name), "traces/trace_%Y%m%d_%H%M%S.json", std::localtime(&now));
+
+	std::error_code error;
+	std::filesystem::create_directories("traces", error);
+
+	bool written = Tracer::write(name);
+	this->showTemporaryMessage(written ? "Trace saved" : "Trace could not be saved");
+	this->clearConsoleRow();
+	std::cout << (written ? "Trace saved: " : "Failed to create ") << name;
+}
+
+void Game::scrubRewind(int ticks)
+{
+	/*
+		@return void
+
+		Pauses the game and moves the grid the given number of ticks back (negative)
+		or forward through the rewind buffer. Resuming continues from the shown tick.
+	*/
+
+	if (this->rewind.getLastTick() < 0) return;
+
+	this->isPaused = true;
+	int target = std::clamp(this->rewindTick + ticks, this->rewind.getFirstTick(), this->rewind.getLastTick());
+	if (!this->rewind.restore(target, this->rewindCells)) return;
+
+	this->restoreState(this->rewindCells);
+	this->updateVertexColors();
+	this->rewindTick = target;
 
-	if (sf::Mouse::isButtonPressed(sf::Mouse::Right))
-		clearArea();
+	int behind = this->rewind.getLastTick() - target;
+	this->showTemporaryMessage(behind > 0 ? "Rewind: " + std::to_string(behind) + " ticks back" : "Rewind: latest tick");
+	this->clearConsoleRow();
+	std::cout << "Rewind: " << behind << " of " << this->rewind.getLastTick() - this->rewind.getFirstTick()
+		<< " ticks back (" << this->rewind.getByteCount() / 1024 << " KB)";
 }
 
 void Game::updateVertexColors() {
@@ -513,15 +1347,28 @@ void Game::updateVertexColors() {
 		Updates colors of the vertex grid
 	*/
 
+	TRACE_SCOPE("updateVertexColors");
+
 	for (int y = 0; y < gridHeight; y++) {
 		for (int x = 0; x < gridWidth; x++) {
 			int i = (x + y * gridWidth) * 4;
 
 			sf::Color color = DEFAULT_COLOR;
-			const std::unique_ptr<Material>& material = grid[y][x];
+			const std::unique_ptr<Material>& material = this->cell(x, y);
 			if (material && material->getType() != MaterialType::Empty)
 				color = material->getColor();
 
+			if (this->circuit.isPowered(x, y))
+				color = POWERED_COLOR;
+
+			// Gas concentration is blended over the grid
+			if (this->gasMode) {
+				float alpha = std::min(this->gasField.getDensity(x, y), 1.0f) * GAS_OVERLAY_OPACITY;
+				color.r = static_cast<sf::Uint8>(color.r + (GAS_OVERLAY_COLOR.r - color.r) * alpha);
+				color.g = static_cast<sf::Uint8>(color.g + (GAS_OVERLAY_COLOR.g - color.g) * alpha);
+				color.b = static_cast<sf::Uint8>(color.b + (GAS_OVERLAY_COLOR.b - color.b) * alpha);
+			}
+
 			for (int j = 0; j < 4; j++)
 				vertexGrid[i + j].color = color;
 		}
@@ -535,7 +1382,46 @@ void Game::updateFPS() {
 		frameCount = 0;
 		fpsClock.restart();
 
-		this->fpsText.setString("FPS: " + std::to_string(static_cast<int>(this->fps)));
+		std::ostringstream work;
+		work.precision(1);
+		work << std::fixed << this->governor.getAverageWork() * 1000.0f;
+
+		std::ostringstream jitter;
+		jitter.precision(2);
+		jitter << std::fixed << this->pacer.getJitter() * 1000.0f;
+
+		this->fpsText.setString("FPS: " + std::to_string(static_cast<int>(this->fps)) + "/" + std::to_string(this->pacer.getTargetRate()) +
+			"  Work: " + work.str() + " ms  Jitter: " + jitter.str() + " ms" +
+			"  Quality: " + std::to_string(GOVERNOR_MAX_LEVEL - this->governor.getLevel()) + "/" + std::to_string(GOVERNOR_MAX_LEVEL) +
+			" (" + this->governor.getLevelName() + ")");
+	}
+}
+
+void Game::setGasMode(bool enabled)
+{
+	/*
+		@return void
+
+		Switches between smoke cells and the smoke concentration field,
+		converting whatever smoke is already on the screen
+	*/
+
+	if (enabled == this->gasMode) return;
+
+	if (enabled) {
+		this->gasMode = true;
+		for (int y = 0; y < gridHeight; y++)
+			for (int x = 0; x < gridWidth; x++)
+				if (this->cell(x, y)->getType() == MaterialType::Smoke)
+					this->setMaterialAt(MaterialType::Smoke, x, y);
+	}
+	else {
+		this->gasMode = false;
+		for (int y = 0; y < gridHeight; y++)
+			for (int x = 0; x < gridWidth; x++)
+				if (this->gasField.getDensity(x, y) >= 0.5f && this->isEmpty(x, y))
+					this->setMaterialAt(MaterialType::Smoke, x, y);
+		this->gasField.clear();
 	}
 }
 
@@ -563,6 +1449,30 @@ void Game::updateSelectedMaterialText()
 	case MaterialType::Smoke:
 		this->selectedMaterialText.setString("Smoke");
 		break;
+	case MaterialType::Lava:
+		this->selectedMaterialText.setString("Lava");
+		break;
+	case MaterialType::Fire:
+		this->selectedMaterialText.setString("Fire");
+		break;
+	case MaterialType::Vent:
+		this->selectedMaterialText.setString("Vent");
+		break;
+	case MaterialType::Wire:
+		this->selectedMaterialText.setString("Wire");
+		break;
+	case MaterialType::Battery:
+		this->selectedMaterialText.setString("Battery");
+		break;
+	case MaterialType::Inverter:
+		this->selectedMaterialText.setString("Inverter");
+		break;
+	case MaterialType::Plant:
+		this->selectedMaterialText.setString("Plant");
+		break;
+	default:
+		this->selectedMaterialText.setString(getMaterialInfo(this->currentMaterial).name);
+		break;
 	}
 
 	this->selectedMaterialText.setPosition(uiScaler.scalePosition(showFps ? sf::Vector2f(10, 35) : sf::Vector2f(10, 0)));
@@ -662,25 +1572,91 @@ void Game::drawCell(int x, int y, sf::Color color)
 
 
 // === Interaction ===
-void Game::spawnMaterial()
+void Game::paintSample(const InputSample& sample)
 {
 	/*
 		@return void
 
-		reates a material area in the grid with the mouse
+		- end the stroke when no button is held
+		- add the cell under the sample to the stroke path
+		- stamp the brush along the path, at most once per frame period of the pacer
+
+		Stamps follow the sample times instead of the frames, so a fast drag leaves no
+		gaps and the brush lays down as much material at any frame rate. The stamp
+		interval follows the target rate, so one stamp per frame at the frame limit.
 	*/
 
-	sf::Vector2i worldMousePos = getMousePosition();
+	bool erasing = sample.right && !sample.left;
+
+	// One undo step covers everything painted while a button is held
+	if (!sample.left && !sample.right) {
+		if (this->strokePath.size() > 1)
+			this->stampStroke();
+		this->strokePath.clear();
+		if (this->history.isStroking())
+			this->history.endStroke();
+		return;
+	}
 
-	forEachInBrush(worldMousePos, 
+	if (!this->history.isStroking())
+		this->history.beginStroke();
+
+	// Switching between painting and erasing starts a new path
+	if (erasing != this->strokeErases) {
+		if (this->strokePath.size() > 1)
+			this->stampStroke();
+		this->strokePath.clear();
+		this->strokeErases = erasing;
+	}
+
+	sf::Vector2f worldPos = this->window->mapPixelToCoords(sample.position);
+	sf::Vector2i cell(static_cast<int>(worldPos.x) / cellSize, static_cast<int>(worldPos.y) / cellSize);
+
+	bool starting = this->strokePath.empty();
+	if (starting || this->strokePath.back() != cell)
+		this->strokePath.push_back(cell);
+
+	std::int64_t stampInterval = 1000000 / this->pacer.getTargetRate();  // microseconds
+	if (starting || sample.time - this->lastStampTime >= stampInterval) {
+		this->stampStroke();
+		this->lastStampTime = sample.time;
+	}
+}
+
+void Game::stampStroke()
+{
+	/*
+		@return void
+
+		Paints or erases along the stroke path, then keeps its last cell as the start of the next part
+	*/
+
+	if (this->strokeErases)
+		this->clearArea(this->strokePath);
+	else
+		this->spawnMaterial(this->strokePath);
+
+	this->strokePath.erase(this->strokePath.begin(), this->strokePath.end() - 1);
+}
+
+void Game::spawnMaterial(const std::vector<sf::Vector2i>& path)
+{
+	/*
+		@return void
+
+		reates material along a brush stroke
+	*/
+
+	this->saveBrushArea(path);
+
+	forEachInStroke(path,
 		[&](int x, int y) {
 			auto isSolidUnmovable = [&]() -> bool {
 				return static_cast<MaterialState>(static_cast<uint16_t>(this->currentMaterial) & (STATE_MASK | SOLID_TYPE_BIT)) == MaterialState::SolidUnmovable;
 				};
 		if (isSolidUnmovable() || getRandom()() / static_cast<float>(this->gen.max()) <= this->brushSolidity)
 			setMaterialAt(this->currentMaterial, x, y);
-		},
-		BrushActionType::SPAWN);
+		});
 }
 
 std::unique_ptr<Material> Game::createMaterial(MaterialType type, int x = 0, int y = 0)
@@ -699,23 +1675,55 @@ std::unique_ptr<Material> Game::createMaterial(MaterialType type, int x = 0, int
 		case MaterialType::Brick: return std::make_unique<BrickMaterial>(x, y);
 		case MaterialType::Oil: return std::make_unique<OilMaterial>();
 		case MaterialType::Smoke: return std::make_unique<SmokeMaterial>();
-		default: return std::make_unique<EmptyMaterial>();
+		case MaterialType::Lava: return std::make_unique<LavaMaterial>();
+		case MaterialType::Steam: return std::make_unique<SteamMaterial>();
+		case MaterialType::Fire: return std::make_unique<FireMaterial>();
+		case MaterialType::Vent: return std::make_unique<VentMaterial>(x, y);
+		case MaterialType::Wire: return std::make_unique<WireMaterial>();
+		case MaterialType::Battery: return std::make_unique<BatteryMaterial>();
+		case MaterialType::Inverter: return std::make_unique<InverterMaterial>();
+		case MaterialType::Plant: return std::make_unique<PlantMaterial>();
+		default:
+			if (const MaterialDefinition* definition = findMaterialDefinition(type))
+				return createDefinedMaterial(*definition);
+			return std::make_unique<EmptyMaterial>();
 	}
 }
 
-void Game::clearArea()
+void Game::clearArea(const std::vector<sf::Vector2i>& path)
 {
 	/*
 		@return void
 
-		Erases the material area in the grid with the mouse
+		Erases material along a brush stroke
 	*/
 
-	sf::Vector2i worldMousePos = getMousePosition();
+	this->saveBrushArea(path);
 
-	forEachInBrush(worldMousePos, [&](int x, int y) {
+	forEachInStroke(path, [&](int x, int y) {
 		setMaterialAt(MaterialType::Empty, x, y);
-		}, BrushActionType::CLEAR);
+		});
+}
+
+void Game::saveBrushArea(const std::vector<sf::Vector2i>& path)
+{
+	/*
+		@return void
+
+		Saves the chunks under the brush stroke into the current undo step before they change
+	*/
+
+	int left = path.front().x, right = left;
+	int top = path.front().y, bottom = top;
+	for (const sf::Vector2i& point : path) {
+		left = std::min(left, point.x);
+		right = std::max(right, point.x);
+		top = std::min(top, point.y);
+		bottom = std::max(bottom, point.y);
+	}
+
+	int reach = this->brushSize + 1;  // the triangle brush starts one row above its box
+	this->history.touchArea(*this, left - reach, top - reach, right + reach, bottom + reach);
 }
 
 template<typename Func>
@@ -781,6 +1789,107 @@ void Game::forEachInBrush(const sf::Vector2i& mousePos, Func func, BrushActionTy
 	}
 }
 
+template<typename Func>
+void Game::forEachInStroke(const std::vector<sf::Vector2i>& path, Func func)
+{
+	/*
+		@return void
+
+		Calls func once for every grid cell the brush covers while it moves along path.
+		The brush is stamped at every cell of the lines between the path points and its
+		rows are merged into spans, so overlapping stamps don't paint a cell twice.
+	*/
+
+	int reach = this->brushSize + 1;  // the triangle brush starts one row above its box
+
+	int top = path.front().y, bottom = top;
+	for (const sf::Vector2i& point : path) {
+		top = std::min(top, point.y);
+		bottom = std::max(bottom, point.y);
+	}
+	top = std::max(top - reach, 0);
+	bottom = std::min(bottom + this->brushSize, gridHeight - 1);
+	if (top > bottom) return;
+
+	std::vector<std::vector<std::pair<int, int>>> rows(bottom - top + 1);
+
+	auto stamp = [&](int centerX, int centerY) {
+		for (int dy = -reach; dy <= this->brushSize; dy++) {
+			int y = centerY + dy;
+			int left, right;
+			if (y < top || y > bottom || !getBrushSpan(dy, left, right)) continue;
+
+			rows[y - top].emplace_back(centerX + left, centerX + right);
+		}
+		};
+
+	// Bresenham line between every pair of path points
+	stamp(path.front().x, path.front().y);
+	for (std::size_t i = 1; i < path.size(); i++) {
+		int x = path[i - 1].x, y = path[i - 1].y;
+		int dx = std::abs(path[i].x - x), stepX = x < path[i].x ? 1 : -1;
+		int dy = -std::abs(path[i].y - y), stepY = y < path[i].y ? 1 : -1;
+		int error = dx + dy;
+
+		while (x != path[i].x || y != path[i].y) {
+			int doubled = 2 * error;
+			if (doubled >= dy) { error += dy; x += stepX; }
+			if (doubled <= dx) { error += dx; y += stepY; }
+			stamp(x, y);
+		}
+	}
+
+	for (int y = top; y <= bottom; y++) {
+		std::vector<std::pair<int, int>>& spans = rows[y - top];
+		std::sort(spans.begin(), spans.end());
+
+		int next = 0;  // first column not visited yet in this row
+		for (const auto& [left, right] : spans) {
+			int from = std::max({ left, next, 0 });
+			int to = std::min(right, gridWidth - 1);
+			for (int x = from; x <= to; x++)
+				func(x, y);
+			next = std::max(next, to + 1);
+		}
+	}
+}
+
+bool Game::getBrushSpan(int dy, int& left, int& right) const
+{
+	/*
+		@return bool - true if the brush covers row dy, left and right are then its column offsets
+
+		Row dy is counted from the brush center, the same shapes as forEachInBrush
+	*/
+
+	if (this->brushShape == BrushShape::TRIANGLE) {
+		int fullSize = this->brushSize * 2;
+		int row = dy + this->brushSize;  // the triangle is drawn from one row above its box
+		if (row < -1 || row > fullSize) return false;
+
+		if (fullSize == 0) {
+			left = right = 0;
+			return row == 0;
+		}
+
+		float ratio = static_cast<float>(row + 1) / fullSize;
+		int halfWidth = static_cast<int>(std::round((ratio * fullSize) / 2.0f));
+		left = -halfWidth;
+		right = halfWidth;
+		return true;
+	}
+
+	if (std::abs(dy) > this->brushSize) return false;
+
+	int halfWidth = this->brushSize;
+	if (this->brushShape == BrushShape::CIRCLE)
+		halfWidth = static_cast<int>(std::sqrt(static_cast<float>(this->brushSize * this->brushSize - dy * dy)));
+
+	left = -halfWidth;
+	right = halfWidth;
+	return true;
+}
+
 sf::Vector2i Game::getMousePosition()
 {
 	sf::Vector2i pixelPos = sf::Mouse::getPosition(*window);
@@ -819,6 +1928,16 @@ void Game::printTips()
 	std::cout << "5 - Brick" << std::endl;
 	std::cout << "6 - Oil" << std::endl;
 	std::cout << "7 - Smoke" << std::endl;
+	std::cout << "8 - Lava" << std::endl;
+	std::cout << "9 - Fire" << std::endl;
+	std::cout << "0 - Vent" << std::endl;
+	std::cout << "W - Wire" << std::endl;
+	std::cout << "E - Battery" << std::endl;
+	std::cout << "N - Inverter (NOT gate, input on the left, output on the right)" << std::endl;
+	std::cout << "L - Plant (grows into water)" << std::endl;
+	for (const MaterialDefinition& definition : getMaterialDefinitions())
+		if (definition.key)
+			std::cout << definition.key << " - " << definition.name << std::endl;
 	std::cout << "Left Mouse Click - Spawn material" << std::endl;
 	std::cout << "Right Mouse Click - Erase" << std::endl;
 	std::cout << "+ - Increase brush size" << std::endl;
@@ -830,8 +1949,15 @@ void Game::printTips()
 	std::cout << "Arrow Left - Scaling down" << std::endl;
 	std::cout << "C - Clear screen" << std::endl;
 	std::cout << "B - Enable/Disable borders" << std::endl;
+	std::cout << "G - Enable/Disable gas field mode" << std::endl;
+	std::cout << "M - Switch engine (Classic/Block automaton)" << std::endl;
 	std::cout << "V - Resize view/hange window mode (Fit/Stretch)" << std::endl;
 	std::cout << "F11 - Displaying the game (Window/Fullscreen)" << std::endl;
+	std::cout << "R - Start/Stop replay recording" << std::endl;
+	std::cout << "F12 - Start/Stop timeline tracing" << std::endl;
+	std::cout << "[ / ] - Step the simulation back/forward (Shift: 10 ticks)" << std::endl;
+	std::cout << "Ctrl + Z - Undo" << std::endl;
+	std::cout << "Ctrl + Y - Redo" << std::endl;
 	std::cout << "Pause - Pause" << std::endl;
 	std::cout << "ESC - End the game" << std::endl << std::endl;
 	std::cout << "Game STARTED";
@@ -839,6 +1965,7 @@ void Game::printTips()
 
 void Game::clearConsoleRow()
 {
+#ifdef _WIN32
 	CONSOLE_SCREEN_BUFFER_INFO csbi;
 	int width = 80;
 
@@ -846,4 +1973,8 @@ void Game::clearConsoleRow()
 		width = csbi.srWindow.Right - csbi.srWindow.Left + 1;
 
 	std::cout << "\r" << std::string(width - 1, ' ') << "\r";
+#else
+	// ANSI terminals erase the row themselves
+	std::cout << "\r\033[K";
+#endif
 }
\ No newline at end of file
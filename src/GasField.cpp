@@ -0,0 +1,120 @@
+#include "GasField.h"
+
+// Project headers
+#include "Tracer.h"
+
+// STL
+#include <algorithm>
+
+// === Constructors ===
+GasField::GasField() { }
+
+// === Accessors ===
+float GasField::getDensity(int x, int y) const
+{
+	return this->density[this->index(x, y)];
+}
+
+bool GasField::isIdle() const
+{
+	return this->peak < GAS_IDLE_DENSITY;
+}
+
+void GasField::add(int x, int y, float amount)
+{
+	float& density = this->density[this->index(x, y)];
+	density += amount;
+	this->peak = std::max(this->peak, density);
+}
+
+void GasField::clear()
+{
+	std::fill(this->density.begin(), this->density.end(), 0.0f);
+	this->peak = 0.0f;
+}
+
+// === Grid sync ===
+void GasField::resize(int width, int height)
+{
+	this->width = width;
+	this->height = height;
+	this->stride = width + 2;
+
+	std::size_t size = static_cast<std::size_t>(this->stride) * (height + 2);
+	this->density.assign(size, 0.0f);
+	this->nextDensity.assign(size, 0.0f);
+	this->open.assign(size, 0.0f);
+	this->rowPeaks.assign(height, 0.0f);
+	this->peak = 0.0f;
+}
+
+void GasField::setOpen(int x, int y, bool open)
+{
+	// A solid or liquid painted over gas displaces it, it must not stay trapped under the cell
+	std::size_t i = this->index(x, y);
+	this->open[i] = open ? 1.0f : 0.0f;
+	if (!open) {
+		this->density[i] = 0.0f;
+		this->nextDensity[i] = 0.0f;
+	}
+}
+
+void GasField::swapCells(int x1, int y1, int x2, int y2)
+{
+	// The gas moves with its empty cell, it would be trapped in the solid or liquid otherwise
+	std::size_t i1 = this->index(x1, y1);
+	std::size_t i2 = this->index(x2, y2);
+	std::swap(this->open[i1], this->open[i2]);
+	std::swap(this->density[i1], this->density[i2]);
+}
+
+// === Main logic ===
+void GasField::step(ThreadPool& pool)
+{
+	/*
+		@return void
+
+		Advances the concentration by one tick: exchange with open side neighbours,
+		move a share one cell up, then decay. Every flow is gated by the open mask
+		of both cells, so gas stays out of solids and liquids and the total only
+		changes through decay.
+	*/
+
+	TRACE_SCOPE("Gas field");
+
+	pool.parallelFor(0, this->height, [this](int from, int to) {
+		for (int y = from; y < to; y++) {
+			int row = this->index(0, y);
+
+			const float* c = &this->density[row];
+			const float* cUp = c - this->stride;
+			const float* cDown = c + this->stride;
+			const float* o = &this->open[row];
+			const float* oUp = o - this->stride;
+			const float* oDown = o + this->stride;
+			float* out = &this->nextDensity[row];
+
+			for (int x = 0; x < this->width; x++) {
+				float exchange = o[x - 1] * (c[x - 1] - c[x]) + o[x + 1] * (c[x + 1] - c[x])
+					+ oUp[x] * (cUp[x] - c[x]) + oDown[x] * (cDown[x] - c[x]);
+				float rise = oDown[x] * cDown[x] - oUp[x] * c[x];
+
+				out[x] = GAS_DECAY * (c[x] + o[x] * (GAS_DIFFUSION * exchange + GAS_RISE * rise));
+			}
+
+			float peak = 0.0f;
+			for (int x = 0; x < this->width; x++)
+				peak = std::max(peak, out[x]);
+			this->rowPeaks[y] = peak;
+		}
+		}, 16);
+
+	this->density.swap(this->nextDensity);
+	this->peak = this->rowPeaks.empty() ? 0.0f : *std::max_element(this->rowPeaks.begin(), this->rowPeaks.end());
+}
+
+// === Private ===
+int GasField::index(int x, int y) const
+{
+	return (y + 1) * this->stride + x + 1;
+}
@@ -0,0 +1,166 @@
+#include "GrowthSystem.h"
+
+// Project headers
+#include "Game.h"
+#include "Tracer.h"
+
+// STL
+#include <algorithm>
+
+// === Constructors ===
+GrowthSystem::GrowthSystem() { }
+
+// === Accessors ===
+std::size_t GrowthSystem::getFrontCount() const
+{
+	return this->fronts.size();
+}
+
+bool GrowthSystem::isIdle() const
+{
+	return this->fronts.empty();
+}
+
+// === Grid sync ===
+void GrowthSystem::resize(int width, int height)
+{
+	this->width = width;
+	this->height = height;
+
+	std::size_t size = static_cast<std::size_t>(width) * height;
+	this->plants.assign(size, 0);
+	this->plantCount = 0;
+	this->fronts.clear();
+	this->frontSlots.assign(size, -1);
+}
+
+void GrowthSystem::setMaterial(int x, int y, MaterialType type)
+{
+	/*
+		@return void
+
+		Placement hook. New plants become fronts, and a cell they can grow into
+		wakes up the plants next to it.
+	*/
+
+	int c = y * this->width + x;
+	bool isPlant = type == MaterialType::Plant;
+
+	if (isPlant != (this->plants[c] != 0)) {
+		this->plants[c] = isPlant ? 1 : 0;
+		this->plantCount += isPlant ? 1 : -1;
+	}
+
+	// Dead fronts are dropped lazily when they are drawn
+	if (isPlant)
+		this->addFront(c);
+	else if (canGrowInto(type))
+		this->wakeNeighbors(c);
+}
+
+void GrowthSystem::moveMaterial(int x, int y, MaterialType type)
+{
+	/*
+		@return void
+
+		Swap hook. Plants never move, so only a material arriving next to them matters.
+	*/
+
+	if (this->plantCount > 0 && canGrowInto(type))
+		this->wakeNeighbors(y * this->width + x);
+}
+
+// === Main logic ===
+void GrowthSystem::update(Game& game)
+{
+	/*
+		@return void
+
+		- draw a batch of random fronts
+		- try to grow each into a random neighbour
+		- drop fronts that have nothing left to grow into
+
+		Advances growth by one tick.
+	*/
+
+	TRACE_SCOPE("Plant growth");
+
+	if (this->fronts.empty()) return;
+
+	std::mt19937& rng = game.getRandom();
+	std::size_t attempts = std::max<std::size_t>(GROWTH_MIN_ATTEMPTS,
+		static_cast<std::size_t>(this->fronts.size() * GROWTH_ATTEMPT_SHARE));
+
+	for (std::size_t i = 0; i < attempts && !this->fronts.empty(); i++) {
+		int c = this->fronts[rng() % this->fronts.size()];
+
+		if (!this->plants[c]) {
+			this->removeFront(c);
+			continue;
+		}
+
+		int n = this->neighbor(c, rng() % 4);
+		if (n >= 0 && canGrowInto(game.getMaterialType(n % this->width, n / this->width)) && rng() < GROWTH_CHANCE)
+			game.setMaterialAt(MaterialType::Plant, n % this->width, n / this->width);
+
+		if (!this->hasRoomToGrow(game, c))
+			this->removeFront(c);
+	}
+}
+
+// === Private ===
+bool GrowthSystem::canGrowInto(MaterialType type)
+{
+	return type == MaterialType::Water;
+}
+
+void GrowthSystem::addFront(int c)
+{
+	if (this->frontSlots[c] >= 0) return;
+
+	this->frontSlots[c] = static_cast<int>(this->fronts.size());
+	this->fronts.push_back(c);
+}
+
+void GrowthSystem::removeFront(int c)
+{
+	int slot = this->frontSlots[c];
+	if (slot < 0) return;
+
+	int last = this->fronts.back();
+	this->fronts[slot] = last;
+	this->frontSlots[last] = slot;
+	this->fronts.pop_back();
+	this->frontSlots[c] = -1;
+}
+
+void GrowthSystem::wakeNeighbors(int c)
+{
+	for (int side = 0; side < 4; side++) {
+		int n = this->neighbor(c, side);
+		if (n >= 0 && this->plants[n])
+			this->addFront(n);
+	}
+}
+
+bool GrowthSystem::hasRoomToGrow(Game& game, int c) const
+{
+	for (int side = 0; side < 4; side++) {
+		int n = this->neighbor(c, side);
+		if (n >= 0 && canGrowInto(game.getMaterialType(n % this->width, n / this->width)))
+			return true;
+	}
+	return false;
+}
+
+int GrowthSystem::neighbor(int c, int side) const
+{
+	int x = c % this->width;
+
+	switch (side) {
+		case 0: return x > 0 ? c - 1 : -1;
+		case 1: return x < this->width - 1 ? c + 1 : -1;
+		case 2: return c >= this->width ? c - this->width : -1;
+		default: return c < (this->height - 1) * this->width ? c + this->width : -1;
+	}
+}
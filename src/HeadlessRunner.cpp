@@ -0,0 +1,314 @@
+#include "HeadlessRunner.h"
+
+// Project headers
+#include "FrameCapture.h"
+#include "Game.h"
+#include "MaterialTable.h"
+#include "PerfCounters.h"
+#include "ReplayRecorder.h"
+#include "Tracer.h"
+
+// STL
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <utility>
+#include <vector>
+
+// === Constructors ===
+HeadlessRunner::HeadlessRunner(const HeadlessOptions& options)
+	: options(options) { }
+
+// === Main logic ===
+bool HeadlessRunner::isRequested(int argc, char* argv[])
+{
+	for (int i = 1; i < argc; i++)
+		if (std::strcmp(argv[i], "--headless") == 0)
+			return true;
+	return false;
+}
+
+bool HeadlessRunner::parseArguments(int argc, char* argv[], HeadlessOptions& options)
+{
+	/*
+		@return bool - false on an unknown or incomplete argument
+	*/
+
+	for (int i = 1; i < argc; i++) {
+		std::string argument = argv[i];
+		bool hasValue = i + 1 < argc;
+
+		if (argument == "--headless")
+			continue;
+		else if (argument == "--ticks" && hasValue)
+			options.ticks = std::atoi(argv[++i]);
+		else if (argument == "--scenario" && hasValue)
+			options.scenario = argv[++i];
+		else if (argument == "--capture" && hasValue)
+			options.captureDirectory = argv[++i];
+		else if (argument == "--capture-every" && hasValue)
+			options.captureEvery = std::max(std::atoi(argv[++i]), 1);
+		else if (argument == "--capture-wait")
+			options.captureWait = true;
+		else if (argument == "--record" && hasValue)
+			options.recordPath = argv[++i];
+		else if (argument == "--trace" && hasValue)
+			options.tracePath = argv[++i];
+		else if (argument == "--perf")
+			options.perf = true;
+		else if (argument == "--perf-ticks" && hasValue)
+			options.perfTicksPath = argv[++i];
+		else if (argument == "--engine" && hasValue) {
+			std::string engine = argv[++i];
+			if (engine != "classic" && engine != "margolus") {
+				std::cerr << "Unknown engine: " << engine << " (classic, margolus)" << std::endl;
+				return false;
+			}
+			options.margolus = engine == "margolus";
+		}
+		else if (argument == "--seed" && hasValue) {
+			options.seed = static_cast<std::uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+			options.hasSeed = true;
+		}
+		else if (argument == "--grid" && hasValue) {
+			std::string size = argv[++i];
+			std::size_t separator = size.find('x');
+			if (separator == std::string::npos) return false;
+			options.gridWidth = std::atoi(size.substr(0, separator).c_str());
+			options.gridHeight = std::atoi(size.substr(separator + 1).c_str());
+			if (options.gridWidth <= 0 || options.gridHeight <= 0) return false;
+		}
+		else {
+			std::cerr << "Unknown argument: " << argument << std::endl;
+			return false;
+		}
+	}
+	return true;
+}
+
+int HeadlessRunner::run()
+{
+	/*
+		@return int - process exit code
+
+		- set up the grid, an optional frame capture and an optional replay
+		- run the scenario for the requested number of ticks
+		- wait for the encoder and print a summary
+	*/
+
+	if (this->options.gridWidth > 0) {
+		gridWidth = this->options.gridWidth;
+		gridHeight = this->options.gridHeight;
+	}
+
+	Game game(true);
+	if (this->options.hasSeed)
+		game.setSeed(this->options.seed);
+	game.setEngineMode(this->options.margolus ? EngineMode::Margolus : EngineMode::Classic);
+
+	if (!this->applyScenario(game, -1)) {
+		std::cerr << "Unknown scenario: " << this->options.scenario
+			<< " (empty, sandfall, fire, lava)" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	std::unique_ptr<FrameCapture> capture;
+	if (!this->options.captureDirectory.empty()) {
+		capture = std::make_unique<FrameCapture>(this->options.captureDirectory);
+		if (!capture->isReady()) {
+			std::cerr << "Frame capture disabled, " << this->options.captureDirectory
+				<< " could not be created: " << capture->getError() << std::endl;
+			capture.reset();
+		}
+	}
+
+	ReplayRecorder recorder;
+	std::vector<std::uint32_t> cells;
+	if (!this->options.recordPath.empty() && !recorder.open(this->options.recordPath, gridWidth, gridHeight)) {
+		std::cerr << "Failed to create " << this->options.recordPath << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	// Counters only measure the simulation thread, which runs the grid update and the color build
+	std::ofstream perfTicks;
+	PerfCounters& counters = game.getPerfCounters();
+	if (this->options.perf || !this->options.perfTicksPath.empty()) {
+		if (!counters.open())
+			std::cerr << "Hardware counters unavailable: " << counters.getError() << std::endl;
+		else if (!this->options.perfTicksPath.empty()) {
+			perfTicks.open(this->options.perfTicksPath);
+			if (!perfTicks) {
+				std::cerr << "Failed to create " << this->options.perfTicksPath << std::endl;
+				return EXIT_FAILURE;
+			}
+			perfTicks << "tick,region,cycles,instructions,l1_misses,llc_misses,branch_misses\n";
+		}
+	}
+
+	if (!this->options.tracePath.empty())
+		Tracer::start();
+
+	sf::Clock clock;
+	for (int tick = 0; tick < this->options.ticks; tick++) {
+		this->applyScenario(game, tick);
+		game.update();
+
+		if (capture && tick % this->options.captureEvery == 0) {
+			// The simulation only pays for the copy, encoding runs on the capture threads
+			if (std::vector<std::uint8_t>* buffer = capture->acquire(this->options.captureWait)) {
+				game.copyFrame(*buffer);
+				capture->submit(buffer, tick, gridWidth, gridHeight);
+			}
+		}
+
+		if (recorder.isRecording()) {
+			game.packCells(cells);
+			recorder.record(cells);
+		}
+
+		if (perfTicks.is_open()) {
+			for (std::size_t region = 0; region < PERF_REGION_COUNT; region++) {
+				const PerfReading& reading = counters.getTickReading(static_cast<PerfRegion>(region));
+				perfTicks << tick << "," << PerfCounters::getRegionName(static_cast<PerfRegion>(region));
+				for (std::uint64_t value : reading.values)
+					perfTicks << "," << value;
+				perfTicks << "\n";
+			}
+		}
+	}
+	float simulationSeconds = clock.getElapsedTime().asSeconds();
+
+	if (!this->options.tracePath.empty()) {
+		Tracer::stop();
+		if (!Tracer::write(this->options.tracePath))
+			std::cerr << "Failed to create " << this->options.tracePath << std::endl;
+	}
+
+	std::cout << "Scenario " << this->options.scenario << ": " << this->options.ticks << " ticks on "
+		<< gridWidth << "x" << gridHeight << " in " << simulationSeconds << " s ("
+		<< simulationSeconds * 1000.0f / std::max(this->options.ticks, 1) << " ms per tick)" << std::endl;
+
+	// Final material counts, largest first
+	std::vector<std::pair<std::size_t, std::size_t>> census;
+	for (std::size_t i = 0; i < getMaterialCount(); i++)
+		if (getMaterialInfoByIndex(i).type != MaterialType::Empty && game.getCensus().getCountByIndex(i) > 0)
+			census.push_back({ game.getCensus().getCountByIndex(i), i });
+	std::sort(census.rbegin(), census.rend());
+
+	std::cout << "Census:";
+	for (const auto& [count, index] : census)
+		std::cout << " " << getMaterialInfoByIndex(index).name << " " << count;
+	std::cout << (census.empty() ? " empty" : "") << std::endl;
+
+	if (counters.isOpen())
+		this->reportCounters(counters);
+
+	if (recorder.isRecording()) {
+		recorder.close();
+		std::cout << "Replay saved: " << recorder.getPath() << " (" << recorder.getTickCount() << " ticks, "
+			<< recorder.getByteCount() / 1024 << " KB)" << std::endl;
+	}
+
+	if (capture) {
+		capture->flush();
+		std::cout << "Frames saved: " << capture->getSavedCount()
+			<< ", dropped: " << capture->getDroppedCount()
+			<< ", failed: " << capture->getFailedCount() << std::endl;
+		if (capture->getFailedCount() > 0)
+			return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
+
+// === Private ===
+void HeadlessRunner::reportCounters(const PerfCounters& counters) const
+{
+	/*
+		@return void
+
+		Prints the counts per tick of every region, with misses per thousand instructions.
+		Events the CPU does not count are left out.
+	*/
+
+	int ticks = std::max(counters.getTickCount(), 1);
+
+	for (std::size_t region = 0; region < PERF_REGION_COUNT; region++) {
+		const PerfReading& total = counters.getTotalReading(static_cast<PerfRegion>(region));
+		double instructions = static_cast<double>(total.get(PerfEvent::Instructions));
+
+		std::cout << "Counters, " << PerfCounters::getRegionName(static_cast<PerfRegion>(region)) << " per tick:";
+		const char* separator = " ";
+		for (std::size_t event = 0; event < PERF_EVENT_COUNT; event++) {
+			if (!counters.hasEvent(static_cast<PerfEvent>(event))) continue;
+
+			std::cout << separator << total.values[event] / ticks << " " << PerfCounters::getEventName(static_cast<PerfEvent>(event));
+			if (event >= static_cast<std::size_t>(PerfEvent::L1Misses) && instructions > 0)
+				std::cout << " (" << total.values[event] * 1000.0 / instructions << "/k instr)";
+			separator = ", ";
+		}
+
+		if (total.get(PerfEvent::Cycles) > 0 && instructions > 0)
+			std::cout << ", IPC " << instructions / total.get(PerfEvent::Cycles);
+		std::cout << std::endl;
+	}
+}
+
+bool HeadlessRunner::applyScenario(Game& game, int tick) const
+{
+	/*
+		@return bool - false for an unknown scenario
+
+		Places the materials of the scenario for this tick. Tick -1 only checks the name.
+	*/
+
+	auto fill = [&](MaterialType type, int left, int top, int right, int bottom) {
+		for (int y = top; y < bottom; y++)
+			for (int x = left; x < right; x++)
+				game.setMaterialAt(type, x, y);
+		};
+
+	const std::string& scenario = this->options.scenario;
+
+	if (scenario == "empty")
+		return true;
+
+	if (scenario == "sandfall") {
+		// Streams of sand and dirt poured from the top onto a brick floor
+		if (tick == 0)
+			fill(MaterialType::Brick, 0, gridHeight - 2, gridWidth, gridHeight);
+		if (tick >= 0) {
+			for (int stream = 1; stream < 8; stream++) {
+				int x = gridWidth * stream / 8;
+				if (game.isEmpty(x, 0))
+					game.setMaterialAt(stream % 2 ? MaterialType::Sand : MaterialType::Dirt, x, 0);
+			}
+		}
+		return true;
+	}
+
+	if (scenario == "fire") {
+		// An oil pool in a stone basin, lit after it settles
+		if (tick == 0) {
+			fill(MaterialType::Stone, 0, gridHeight - 2, gridWidth, gridHeight);
+			fill(MaterialType::Oil, gridWidth / 4, gridHeight * 2 / 3, gridWidth * 3 / 4, gridHeight - 2);
+		}
+		if (tick == 30)
+			fill(MaterialType::Fire, gridWidth / 4, gridHeight * 2 / 3 - 2, gridWidth * 3 / 4, gridHeight * 2 / 3);
+		return true;
+	}
+
+	if (scenario == "lava") {
+		// Lava poured into a pool of water
+		if (tick == 0)
+			fill(MaterialType::Water, 0, gridHeight * 2 / 3, gridWidth, gridHeight);
+		if (tick >= 0 && tick < 300)
+			fill(MaterialType::Lava, gridWidth / 2 - 2, 0, gridWidth / 2 + 2, 1);
+		return true;
+	}
+
+	return false;
+}
@@ -0,0 +1,191 @@
+#include "HeatField.h"
+
+// STL
+#include <algorithm>
+#include <cmath>
+
+// === Constructors ===
+HeatField::HeatField()
+{
+	std::size_t count = getMaterialCount();
+	this->materialConductivity.resize(count);
+	this->materialRate.resize(count);
+	this->materialExchange.resize(count);
+	this->lowTemperature.resize(count);
+	this->highTemperature.resize(count);
+
+	for (std::size_t i = 0; i < count; i++) {
+		const MaterialInfo& info = getMaterialInfoByIndex(i);
+
+		// Flow from a neighbour is rate * k_neighbour * dT, so a cell with four
+		// neighbours never moves past their weighted average (stable explicit step)
+		this->materialConductivity[i] = info.thermal.conductivity;
+		this->materialRate[i] = 0.25f * info.thermal.conductivity / info.thermal.heatCapacity;
+		this->materialExchange[i] = info.thermal.ambientExchange;
+		this->lowTemperature[i] = info.phase.lowTemperature;
+		this->highTemperature[i] = info.phase.highTemperature;
+	}
+}
+
+// === Accessors ===
+float HeatField::getTemperature(int x, int y) const
+{
+	return this->temperature[this->index(x, y)];
+}
+
+void HeatField::setTemperature(int x, int y, float temperature)
+{
+	this->temperature[this->index(x, y)] = temperature;
+	this->settled = false;
+}
+
+bool HeatField::isIdle() const
+{
+	/*
+		@return bool - true if the field is at rest and steps would not lead to phase changes
+	*/
+
+	return this->settled;
+}
+
+// === Grid sync ===
+void HeatField::resize(int width, int height)
+{
+	this->width = width;
+	this->height = height;
+	this->stride = width + 2;
+
+	// The halo keeps zero conductivity, so edges behave as insulated walls
+	std::size_t size = static_cast<std::size_t>(this->stride) * (height + 2);
+	this->materials.assign(size, 0);
+	this->temperature.assign(size, AMBIENT_TEMPERATURE);
+	this->nextTemperature.assign(size, AMBIENT_TEMPERATURE);
+	this->conductivity.assign(size, 0.0f);
+	this->rate.assign(size, 0.0f);
+	this->exchange.assign(size, 0.0f);
+
+	this->rowTransitions.assign(height, {});
+	this->transitions.clear();
+	this->rowChanges.assign(height, 0.0f);
+	this->settled = true;
+}
+
+void HeatField::setMaterial(int x, int y, MaterialType type)
+{
+	int i = this->index(x, y);
+	this->materials[i] = static_cast<std::uint8_t>(materialIndex(type));
+	this->temperature[i] = getMaterialInfo(type).thermal.spawnTemperature;
+	this->settled = false;
+}
+
+void HeatField::swapCells(int x1, int y1, int x2, int y2)
+{
+	int a = this->index(x1, y1);
+	int b = this->index(x2, y2);
+	std::swap(this->materials[a], this->materials[b]);
+	std::swap(this->temperature[a], this->temperature[b]);
+	this->settled = false;
+}
+
+void HeatField::shiftColumnDown(int x, int top, int bottom)
+{
+	/*
+		@return void
+
+		Moves cells top..bottom of column x one cell down, the cell below the run goes to the top.
+	*/
+
+	int below = this->index(x, bottom + 1);
+	std::uint8_t material = this->materials[below];
+	float temperature = this->temperature[below];
+
+	for (int c = below; c > this->index(x, top); c -= this->stride) {
+		this->materials[c] = this->materials[c - this->stride];
+		this->temperature[c] = this->temperature[c - this->stride];
+	}
+
+	this->materials[this->index(x, top)] = material;
+	this->temperature[this->index(x, top)] = temperature;
+	this->settled = false;
+}
+
+// === Main logic ===
+const std::vector<int>& HeatField::step(ThreadPool& pool)
+{
+	/*
+		@return const std::vector<int>& - cells (y * width + x) that crossed a phase threshold
+
+		- gather per-cell coefficients from the material table
+		- apply the diffusion stencil row by row
+		- collect phase transitions
+
+		Advances the temperature field by one heat tick.
+	*/
+
+	// Gather coefficients into dense arrays so the stencil is a plain streaming loop
+	pool.parallelFor(0, this->height, [this](int from, int to) {
+		for (int y = from; y < to; y++) {
+			int row = this->index(0, y);
+			for (int x = 0; x < this->width; x++) {
+				std::uint8_t m = this->materials[row + x];
+				this->conductivity[row + x] = this->materialConductivity[m];
+				this->rate[row + x] = this->materialRate[m];
+				this->exchange[row + x] = this->materialExchange[m];
+			}
+		}
+		});
+
+	// Five-point stencil, branch free inside the row so the compiler can vectorize it
+	pool.parallelFor(0, this->height, [this](int from, int to) {
+		for (int y = from; y < to; y++) {
+			int row = this->index(0, y);
+
+			const float* t = &this->temperature[row];
+			const float* tUp = t - this->stride;
+			const float* tDown = t + this->stride;
+			const float* k = &this->conductivity[row];
+			const float* kUp = k - this->stride;
+			const float* kDown = k + this->stride;
+			const float* a = &this->rate[row];
+			const float* e = &this->exchange[row];
+			float* out = &this->nextTemperature[row];
+
+			for (int x = 0; x < this->width; x++) {
+				float flow = kUp[x] * tUp[x] + kDown[x] * tDown[x] + k[x - 1] * t[x - 1] + k[x + 1] * t[x + 1];
+				float weight = kUp[x] + kDown[x] + k[x - 1] + k[x + 1];
+				out[x] = t[x] + a[x] * (flow - t[x] * weight) + e[x] * (AMBIENT_TEMPERATURE - t[x]);
+			}
+
+			float change = 0.0f;
+			for (int x = 0; x < this->width; x++)
+				change = std::max(change, std::abs(out[x] - t[x]));
+			this->rowChanges[y] = change;
+
+			// Phase transitions are rare, so this branch is almost always predicted
+			std::vector<int>& found = this->rowTransitions[y];
+			found.clear();
+
+			const std::uint8_t* m = &this->materials[row];
+			for (int x = 0; x < this->width; x++)
+				if (out[x] < this->lowTemperature[m[x]] || out[x] > this->highTemperature[m[x]])
+					found.push_back(y * this->width + x);
+		}
+		});
+
+	this->temperature.swap(this->nextTemperature);
+
+	this->transitions.clear();
+	for (const std::vector<int>& found : this->rowTransitions)
+		this->transitions.insert(this->transitions.end(), found.begin(), found.end());
+
+	// Transitions touch the cells afterwards, which unsettles the field again
+	this->settled = this->rowChanges.empty() || *std::max_element(this->rowChanges.begin(), this->rowChanges.end()) < HEAT_SETTLED_CHANGE;
+
+	return this->transitions;
+}
+
+// === Private ===
+int HeatField::index(int x, int y) const
+{
+	return (y + 1) * this->stride + x + 1;
+}
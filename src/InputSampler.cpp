@@ -0,0 +1,161 @@
+#include "InputSampler.h"
+
+// Project headers
+#include "Tracer.h"
+
+// STL
+#include <chrono>
+
+// === Constructors ===
+InputSampler::InputSampler() { }
+
+InputSampler::~InputSampler()
+{
+	this->stop();
+}
+
+// === Accessors ===
+std::int64_t InputSampler::now()
+{
+	return std::chrono::duration_cast<std::chrono::microseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// === Methods ===
+void InputSampler::start(const sf::Window& window)
+{
+	this->stop();
+
+	this->window = &window;
+	this->stopping = false;
+
+#ifdef _WIN32
+	this->thread = std::thread(&InputSampler::sampleLoop, this);
+#endif
+}
+
+void InputSampler::stop()
+{
+	if (!this->thread.joinable()) return;
+
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		this->stopping = true;
+	}
+	this->pressed.notify_one();
+	this->thread.join();
+}
+
+void InputSampler::press(const sf::Vector2i& position, sf::Mouse::Button button)
+{
+	/*
+		@return void
+
+		Queues the press from its event and starts polling. A click shorter than
+		one poll still paints, the event keeps the position it happened at.
+	*/
+
+	InputSample sample;
+	sample.position = position;
+	sample.left = button == sf::Mouse::Left || sf::Mouse::isButtonPressed(sf::Mouse::Left);
+	sample.right = button == sf::Mouse::Right || sf::Mouse::isButtonPressed(sf::Mouse::Right);
+	sample.time = now();
+
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		this->push(sample);
+		this->pressTime = sample.time;
+		this->sampling = true;
+	}
+	this->pressed.notify_one();
+}
+
+void InputSampler::poll()
+{
+	/*
+		@return void
+
+		Samples once on the caller's thread while a button is held. Does nothing
+		while the sampling thread runs, without it strokes are sampled once per frame.
+	*/
+
+	if (this->thread.joinable() || !this->window) return;
+
+	std::lock_guard<std::mutex> lock(this->mutex);
+	if (this->sampling)
+		this->record(this->takeSample());
+}
+
+void InputSampler::drain(std::vector<InputSample>& samples)
+{
+	/*
+		@return void
+
+		Moves the queued samples into samples, oldest first
+	*/
+
+	std::lock_guard<std::mutex> lock(this->mutex);
+	samples.assign(this->queue.begin(), this->queue.end());
+	this->queue.clear();
+}
+
+// === Private ===
+void InputSampler::sampleLoop()
+{
+	/*
+		@return void
+
+		Sleeps until a press, then polls at a fixed rate until every button is up.
+		The last sample of a stroke has no buttons, it tells the game the stroke ended.
+	*/
+
+	Tracer::setThreadName("Input sampler");
+
+	const std::chrono::microseconds interval(1000000 / INPUT_SAMPLE_RATE);
+	std::unique_lock<std::mutex> lock(this->mutex);
+
+	while (true) {
+		this->pressed.wait(lock, [this] { return this->sampling || this->stopping; });
+		if (this->stopping) return;
+
+		auto next = std::chrono::steady_clock::now();
+		while (this->sampling && !this->stopping) {
+			lock.unlock();
+			InputSample sample = this->takeSample();
+			lock.lock();
+
+			this->record(sample);
+
+			next += interval;
+			this->pressed.wait_until(lock, next, [this] { return this->stopping; });
+		}
+	}
+}
+
+InputSample InputSampler::takeSample() const
+{
+	InputSample sample;
+	sample.time = now();
+	sample.position = sf::Mouse::getPosition(*this->window);
+	sample.left = sf::Mouse::isButtonPressed(sf::Mouse::Left);
+	sample.right = sf::Mouse::isButtonPressed(sf::Mouse::Right);
+	return sample;
+}
+
+void InputSampler::record(const InputSample& sample)
+{
+	// Called with the mutex held. A press queued while the sample was taken is newer, it must not be ended by it
+	if (sample.time >= this->pressTime) {
+		this->push(sample);
+		if (!sample.left && !sample.right)
+			this->sampling = false;
+	}
+}
+
+void InputSampler::push(const InputSample& sample)
+{
+	// Called with the mutex held
+	if (this->queue.size() >= INPUT_QUEUE_LIMIT)
+		this->queue.pop_front();
+	this->queue.push_back(sample);
+}
@@ -1,12 +1,41 @@
 ﻿#include "Game.h"
+#include "HeadlessRunner.h"
+#include "Tracer.h"
+
+// STL
+#include <cstring>
+#include <iostream>
 
 // Main game function
-int main()
+int main(int argc, char* argv[])
 {
+	// Compile material definitions before the simulation fields copy the material table
+	if (!loadMaterialDefinitions("resources/materials.txt"))
+		std::cerr << "resources/materials.txt not found, only built-in materials are available" << std::endl;
+
+	// Names the thread in timeline traces
+	Tracer::setThreadName("Main");
+
+	// Run without a window for scripted scenarios and frame capture
+	if (HeadlessRunner::isRequested(argc, argv)) {
+		HeadlessOptions options;
+		if (!HeadlessRunner::parseArguments(argc, argv, options))
+			return EXIT_FAILURE;
+		return HeadlessRunner(options).run();
+	}
+
 	// Init game engine
 	Game game;
 
-	// Game loop
+	// Play back a recorded replay instead of the simulation
+	for (int i = 1; i + 1 < argc; i++) {
+		if (std::strcmp(argv[i], "--play") == 0 && !game.loadReplay(argv[i + 1])) {
+			std::cerr << argv[i + 1] << " is not a readable replay" << std::endl;
+			return EXIT_FAILURE;
+		}
+	}
+
+	// Game loop, update() waits for the next frame slot, once the scene is idle until the next event
 	while (game.running()) {
 
 		// Update
@@ -0,0 +1,283 @@
+#include "MargolusEngine.h"
+
+// Project headers
+#include "Game.h"
+#include "Materials.h"
+#include "ThreadPool.h"
+
+// STL
+#include <algorithm>
+
+namespace {
+	const int ROW_GRAIN = 8;  // block rows per thread, smaller grids run inline
+
+	// Heavier cells sink below lighter ones, static cells never move
+	int weightOf(BlockClass type)
+	{
+		switch (type) {
+			case BlockClass::Gas: return 0;
+			case BlockClass::Empty: return 1;
+			case BlockClass::Liquid: return 2;
+			case BlockClass::Powder: return 3;
+			default: return -1;
+		}
+	}
+
+	int classIndex(const std::array<BlockClass, 4>& classes)
+	{
+		int index = 0;
+		for (int i = 0; i < 4; i++)
+			index |= static_cast<int>(classes[i]) << (i * MARGOLUS_CLASS_BITS);
+		return index;
+	}
+}
+
+// === Constructors ===
+MargolusEngine::MargolusEngine()
+{
+	this->buildTable();
+}
+
+// === Accessors ===
+BlockClass MargolusEngine::classify(MaterialType type)
+{
+	/*
+		@return BlockClass - movement class of a material, border sentinels included
+	*/
+
+	if (type == MaterialType::Empty || type == MaterialType::Void)
+		return BlockClass::Empty;
+
+	switch (static_cast<MaterialState>(static_cast<uint16_t>(type) & (STATE_MASK | SOLID_TYPE_BIT))) {
+		case MaterialState::SolidMovable: return BlockClass::Powder;
+		case MaterialState::Liquid: return BlockClass::Liquid;
+		case MaterialState::Gaseous: return BlockClass::Gas;
+		default: return BlockClass::Static;
+	}
+}
+
+// === Methods ===
+void MargolusEngine::setSeed(std::uint32_t seed)
+{
+	this->seed = seed;
+}
+
+void MargolusEngine::step(Game& game, ThreadPool& pool, int tick)
+{
+	/*
+		@return void
+
+		- burn out expiring materials
+		- look up the permutation of every block of this tick's phase, in parallel
+		- apply the blocks that change, one after another
+
+		Advances the grid by one tick. Blocks at the edges take in the border cells:
+		walls stay put, and whatever moves into the void is deleted.
+	*/
+
+	const OccupancyMap& occupancy = game.getOccupancy();
+
+	// Flames keep their lifetime in this mode as well
+	for (int y = 0; y < gridHeight; y++) {
+		if (!occupancy.hasMovable(y)) continue;
+
+		for (int x = occupancy.nextMovable(0, y); x < gridWidth; x = occupancy.nextMovable(x + 1, y))
+			if (classify(game.getMaterialType(x, y)) == BlockClass::Gas)
+				game.getRawMaterial(x, y)->expire(x, y, game);
+	}
+
+	int offset = tick & 1;
+	int columns = (gridWidth + offset + 1) / 2;
+	int rows = (gridHeight + offset + 1) / 2;
+	this->moves.resize(static_cast<std::size_t>(columns) * rows);
+
+	auto hasMovable = [&](int y) {
+		return y >= 0 && y < gridHeight && occupancy.hasMovable(y);
+		};
+
+	pool.parallelFor(0, rows, [&](int from, int to) {
+		for (int blockY = from; blockY < to; blockY++) {
+			std::uint8_t* row = &this->moves[static_cast<std::size_t>(blockY) * columns];
+			int y = blockY * 2 - offset;
+
+			// A block row without movable cells stays as it is
+			if (!hasMovable(y) && !hasMovable(y + 1)) {
+				std::fill(row, row + columns, MARGOLUS_IDENTITY);
+				continue;
+			}
+
+			for (int blockX = 0; blockX < columns; blockX++) {
+				int x = blockX * 2 - offset;
+				std::array<BlockClass, 4> classes = {
+					classify(game.getNeighbor(x, y)->getType()),
+					classify(game.getNeighbor(x + 1, y)->getType()),
+					classify(game.getNeighbor(x, y + 1)->getType()),
+					classify(game.getNeighbor(x + 1, y + 1)->getType())
+				};
+
+				std::size_t variant = this->hash(blockX, blockY, tick) & 1;
+				row[blockX] = this->table[variant * MARGOLUS_TABLE_SIZE + classIndex(classes)];
+			}
+		}
+		}, ROW_GRAIN);
+
+	for (int blockY = 0; blockY < rows; blockY++) {
+		for (int blockX = 0; blockX < columns; blockX++) {
+			std::uint8_t permutation = this->moves[static_cast<std::size_t>(blockY) * columns + blockX];
+			if (permutation == MARGOLUS_IDENTITY) continue;
+
+			int x = blockX * 2 - offset;
+			int y = blockY * 2 - offset;
+			int cellX[4] = { x, x + 1, x, x + 1 };
+			int cellY[4] = { y, y, y + 1, y + 1 };
+
+			int sources[4];
+			bool inside[4];
+			for (int i = 0; i < 4; i++) {
+				sources[i] = (permutation >> (i * 2)) & 3;
+				inside[i] = game.isValidPosition(cellX[i], cellY[i]);
+			}
+
+			// Cells moving into the void are deleted, the emptied cells take the place of the void's content
+			int deleted[4];
+			int deletedCount = 0;
+			for (int i = 0; i < 4; i++) {
+				if (inside[i] || !inside[sources[i]]) continue;
+				game.setMaterialAt(MaterialType::Empty, cellX[sources[i]], cellY[sources[i]]);
+				deleted[deletedCount++] = sources[i];
+			}
+			for (int i = 0; i < 4; i++)
+				if (inside[i] && !inside[sources[i]])
+					sources[i] = deleted[--deletedCount];
+
+			// Apply the rest of the permutation as swaps, locations[s] tracks where the content of s is now
+			int locations[4] = { 0, 1, 2, 3 };
+			for (int i = 0; i < 4; i++) {
+				if (!inside[i]) continue;
+
+				int current = locations[sources[i]];
+				if (current == i) continue;
+
+				game.swapMaterials(cellX[i], cellY[i], cellX[current], cellY[current]);
+				for (int& location : locations)
+					if (location == i)
+						location = current;
+				locations[sources[i]] = i;
+			}
+		}
+	}
+}
+
+// === Private ===
+void MargolusEngine::buildTable()
+{
+	/*
+		@return void
+
+		Resolves every combination of classes once. The mirrored half runs the same
+		rules on the block flipped left to right, so neither side is favored.
+	*/
+
+	this->table.assign(2 * MARGOLUS_TABLE_SIZE, MARGOLUS_IDENTITY);
+
+	constexpr int classCount = static_cast<int>(BlockClass::Gas) + 1;
+	for (int a = 0; a < classCount; a++)
+	for (int b = 0; b < classCount; b++)
+	for (int c = 0; c < classCount; c++)
+	for (int d = 0; d < classCount; d++) {
+		std::array<BlockClass, 4> classes = {
+			static_cast<BlockClass>(a), static_cast<BlockClass>(b),
+			static_cast<BlockClass>(c), static_cast<BlockClass>(d)
+		};
+		std::array<BlockClass, 4> mirrored = { classes[1], classes[0], classes[3], classes[2] };
+
+		int index = classIndex(classes);
+		this->table[index] = resolve(classes);
+
+		// Cell i of the mirror is cell i ^ 1 of the block
+		std::uint8_t flipped = resolve(mirrored);
+		std::uint8_t permutation = 0;
+		for (int i = 0; i < 4; i++)
+			permutation |= (((flipped >> ((i ^ 1) * 2)) & 3) ^ 1) << (i * 2);
+		this->table[MARGOLUS_TABLE_SIZE + index] = permutation;
+	}
+}
+
+std::uint8_t MargolusEngine::resolve(const std::array<BlockClass, 4>& classes)
+{
+	/*
+		@return std::uint8_t - permutation of the block, cells 0..3 are top left, top right,
+		                       bottom left, bottom right
+
+		- heavier cells sink below lighter ones in each column
+		- powders and liquids slide down diagonally past a blocked cell, gases rise
+		- liquids and gases that did not move flow to the right
+
+		Every cell moves at most once.
+	*/
+
+	std::array<int, 4> at = { 0, 1, 2, 3 };  // cell whose content is at every position
+	std::array<BlockClass, 4> cells = classes;
+	std::array<bool, 4> moved = {};
+
+	auto movable = [&](int i) { return cells[i] != BlockClass::Static; };
+	auto swap = [&](int i, int j) {
+		std::swap(at[i], at[j]);
+		std::swap(cells[i], cells[j]);
+		moved[i] = moved[j] = true;
+		};
+
+	// Columns
+	for (int top = 0; top < 2; top++)
+		if (movable(top) && movable(top + 2) && weightOf(cells[top]) > weightOf(cells[top + 2]))
+			swap(top, top + 2);
+
+	// Diagonal falls, from the top cell to the opposite bottom cell past the side cell
+	const int falls[2][4] = { { 0, 2, 1, 3 }, { 1, 3, 0, 2 } };  // top, below, side, diagonal
+	for (const auto& [top, below, side, diagonal] : falls) {
+		int weight = weightOf(cells[top]);
+		if (moved[top] || moved[diagonal] || weight < 2) continue;
+
+		bool blocked = !movable(below) || weightOf(cells[below]) >= weight;
+		if (blocked && movable(diagonal) && weightOf(cells[diagonal]) < weight && movable(side) && weightOf(cells[side]) < weight)
+			swap(top, diagonal);
+	}
+
+	// Diagonal rises of gases
+	const int rises[2][4] = { { 2, 0, 3, 1 }, { 3, 1, 2, 0 } };  // bottom, above, side, diagonal
+	for (const auto& [bottom, above, side, diagonal] : rises) {
+		if (moved[bottom] || moved[diagonal] || cells[bottom] != BlockClass::Gas) continue;
+
+		bool blocked = !movable(above) || cells[above] == BlockClass::Gas;
+		if (blocked && movable(diagonal) && cells[diagonal] != BlockClass::Gas && movable(side) && cells[side] != BlockClass::Gas)
+			swap(bottom, diagonal);
+	}
+
+	// Sideways flow, the mirrored table flows to the left
+	for (int left : { 2, 0 }) {
+		int right = left + 1;
+		if (moved[left] || moved[right]) continue;
+
+		bool liquidFlows = cells[left] == BlockClass::Liquid && (cells[right] == BlockClass::Empty || cells[right] == BlockClass::Gas);
+		bool gasFlows = cells[left] == BlockClass::Gas && cells[right] == BlockClass::Empty;
+		if (liquidFlows || gasFlows)
+			swap(left, right);
+	}
+
+	std::uint8_t permutation = 0;
+	for (int i = 0; i < 4; i++)
+		permutation |= at[i] << (i * 2);
+	return permutation;
+}
+
+std::uint32_t MargolusEngine::hash(int blockX, int blockY, int tick) const
+{
+	std::uint32_t h = this->seed ^ (static_cast<std::uint32_t>(blockX) * 0x9E3779B1u)
+		^ (static_cast<std::uint32_t>(blockY) * 0x85EBCA77u) ^ (static_cast<std::uint32_t>(tick) * 0xC2B2AE3Du);
+	h ^= h >> 16;
+	h *= 0x7FEB352Du;
+	h ^= h >> 15;
+	h *= 0x846CA68Bu;
+	h ^= h >> 16;
+	return h;
+}
@@ -0,0 +1,216 @@
+#include "MaterialCensus.h"
+
+// Project headers
+#include "Game.h"
+#include "MaterialTable.h"
+
+// STL
+#include <algorithm>
+
+// === Constructors ===
+MaterialCensus::MaterialCensus() { }
+
+// === Accessors ===
+std::size_t MaterialCensus::getCount(MaterialType type) const
+{
+	return this->counts[materialIndex(type)];
+}
+
+std::size_t MaterialCensus::getCountByIndex(std::size_t index) const
+{
+	return this->counts[index];
+}
+
+// === Grid sync ===
+void MaterialCensus::resize(int width, int height)
+{
+	/*
+		@return void
+
+		Starts from a grid full of Empty, the state the game fills a new grid with
+	*/
+
+	this->width = width;
+	this->height = height;
+	this->chunkColumns = (width + CENSUS_CHUNK_SIZE - 1) / CENSUS_CHUNK_SIZE;
+	this->chunkRows = (height + CENSUS_CHUNK_SIZE - 1) / CENSUS_CHUNK_SIZE;
+	this->materialCount = getMaterialCount();
+
+	std::size_t chunkCount = static_cast<std::size_t>(this->chunkColumns) * this->chunkRows;
+	this->counts.assign(this->materialCount, 0);
+	this->histograms.assign(chunkCount * this->materialCount, 0);
+	this->tables.assign(chunkCount, ChunkTable());
+
+	std::size_t empty = materialIndex(MaterialType::Empty);
+	this->counts[empty] = static_cast<std::size_t>(width) * height;
+	for (int cy = 0; cy < this->chunkRows; cy++) {
+		for (int cx = 0; cx < this->chunkColumns; cx++) {
+			int chunkWidth = std::min(CENSUS_CHUNK_SIZE, width - cx * CENSUS_CHUNK_SIZE);
+			int chunkHeight = std::min(CENSUS_CHUNK_SIZE, height - cy * CENSUS_CHUNK_SIZE);
+			this->histogram(cy * this->chunkColumns + cx, empty) = static_cast<std::uint16_t>(chunkWidth * chunkHeight);
+		}
+	}
+}
+
+void MaterialCensus::setMaterial(int x, int y, MaterialType previous, MaterialType material)
+{
+	int chunk = this->chunkAt(x, y);
+	this->tables[chunk].material = -1;
+	if (previous == material) return;
+
+	std::size_t from = materialIndex(previous);
+	std::size_t to = materialIndex(material);
+	this->counts[from]--;
+	this->counts[to]++;
+	this->histogram(chunk, from)--;
+	this->histogram(chunk, to)++;
+}
+
+void MaterialCensus::swapCells(int x1, int y1, int x2, int y2, MaterialType type1, MaterialType type2)
+{
+	/*
+		@return void
+
+		Swap hook, type1 and type2 are the materials after the swap. Counts only change
+		when the cells belong to different chunks.
+	*/
+
+	int chunk1 = this->chunkAt(x1, y1);
+	int chunk2 = this->chunkAt(x2, y2);
+	this->tables[chunk1].material = -1;
+	this->tables[chunk2].material = -1;
+	if (chunk1 == chunk2 || type1 == type2) return;
+
+	std::size_t index1 = materialIndex(type1);
+	std::size_t index2 = materialIndex(type2);
+	this->histogram(chunk1, index2)--;
+	this->histogram(chunk1, index1)++;
+	this->histogram(chunk2, index1)--;
+	this->histogram(chunk2, index2)++;
+}
+
+void MaterialCensus::shiftColumnDown(const Game& game, int x, int top, int bottom)
+{
+	/*
+		@return void
+
+		Column shift hook, called after the shift. Cells top + 1..bottom + 1 came from
+		the row above them and the cell at top came from bottom + 1, so only the cells
+		that crossed a chunk border change the histograms. The cell at top is empty for
+		free fall, but water or gas when a falling structure sinks through them.
+	*/
+
+	for (int cy = top / CENSUS_CHUNK_SIZE; cy <= (bottom + 1) / CENSUS_CHUNK_SIZE; cy++)
+		this->tables[cy * this->chunkColumns + x / CENSUS_CHUNK_SIZE].material = -1;
+
+	int firstBorder = (top / CENSUS_CHUNK_SIZE + 1) * CENSUS_CHUNK_SIZE;
+	for (int y = firstBorder; y <= bottom + 1; y += CENSUS_CHUNK_SIZE) {
+		std::size_t moved = materialIndex(game.getMaterialType(x, y));
+		this->histogram(this->chunkAt(x, y - 1), moved)--;
+		this->histogram(this->chunkAt(x, y), moved)++;
+	}
+
+	int topChunk = this->chunkAt(x, top);
+	int bottomChunk = this->chunkAt(x, bottom + 1);
+	if (topChunk != bottomChunk) {
+		std::size_t displaced = materialIndex(game.getMaterialType(x, top));
+		this->histogram(bottomChunk, displaced)--;
+		this->histogram(topChunk, displaced)++;
+	}
+}
+
+// === Queries ===
+std::size_t MaterialCensus::countInRegion(const Game& game, MaterialType type, int left, int top, int right, int bottom)
+{
+	/*
+		@return std::size_t - cells of the material in the inclusive rectangle
+
+		Fully covered chunks, and chunks with none or only this material, are answered
+		from the histograms. Other chunks use their summed-area table.
+	*/
+
+	left = std::max(left, 0);
+	top = std::max(top, 0);
+	right = std::min(right, this->width - 1);
+	bottom = std::min(bottom, this->height - 1);
+	if (left > right || top > bottom) return 0;
+
+	std::size_t material = materialIndex(type);
+	std::size_t total = 0;
+
+	for (int cy = top / CENSUS_CHUNK_SIZE; cy <= bottom / CENSUS_CHUNK_SIZE; cy++) {
+		for (int cx = left / CENSUS_CHUNK_SIZE; cx <= right / CENSUS_CHUNK_SIZE; cx++) {
+			int chunk = cy * this->chunkColumns + cx;
+			int chunkLeft = cx * CENSUS_CHUNK_SIZE;
+			int chunkTop = cy * CENSUS_CHUNK_SIZE;
+			int chunkRight = std::min(chunkLeft + CENSUS_CHUNK_SIZE, this->width) - 1;
+			int chunkBottom = std::min(chunkTop + CENSUS_CHUNK_SIZE, this->height) - 1;
+
+			// Part of the region inside this chunk
+			int x0 = std::max(left, chunkLeft);
+			int y0 = std::max(top, chunkTop);
+			int x1 = std::min(right, chunkRight);
+			int y1 = std::min(bottom, chunkBottom);
+
+			std::size_t inChunk = this->histogram(chunk, material);
+			std::size_t chunkArea = static_cast<std::size_t>(chunkRight - chunkLeft + 1) * (chunkBottom - chunkTop + 1);
+
+			if (inChunk == 0) continue;
+			if (inChunk == chunkArea) {
+				total += static_cast<std::size_t>(x1 - x0 + 1) * (y1 - y0 + 1);
+				continue;
+			}
+			if (x0 == chunkLeft && y0 == chunkTop && x1 == chunkRight && y1 == chunkBottom) {
+				total += inChunk;
+				continue;
+			}
+
+			const ChunkTable& table = this->buildTable(game, chunk, material);
+			constexpr int stride = CENSUS_CHUNK_SIZE + 1;
+			x0 -= chunkLeft;
+			y0 -= chunkTop;
+			x1 -= chunkLeft - 1;
+			y1 -= chunkTop - 1;
+			total += table.sums[y1 * stride + x1] - table.sums[y0 * stride + x1]
+				- table.sums[y1 * stride + x0] + table.sums[y0 * stride + x0];
+		}
+	}
+
+	return total;
+}
+
+// === Private ===
+int MaterialCensus::chunkAt(int x, int y) const
+{
+	return (y / CENSUS_CHUNK_SIZE) * this->chunkColumns + x / CENSUS_CHUNK_SIZE;
+}
+
+std::uint16_t& MaterialCensus::histogram(int chunk, std::size_t material)
+{
+	return this->histograms[static_cast<std::size_t>(chunk) * this->materialCount + material];
+}
+
+const MaterialCensus::ChunkTable& MaterialCensus::buildTable(const Game& game, int chunk, std::size_t material)
+{
+	ChunkTable& table = this->tables[chunk];
+	if (table.material == static_cast<int>(material)) return table;
+
+	constexpr int stride = CENSUS_CHUNK_SIZE + 1;
+	table.sums.assign(stride * stride, 0);
+
+	int chunkLeft = (chunk % this->chunkColumns) * CENSUS_CHUNK_SIZE;
+	int chunkTop = (chunk / this->chunkColumns) * CENSUS_CHUNK_SIZE;
+	int chunkWidth = std::min(CENSUS_CHUNK_SIZE, this->width - chunkLeft);
+	int chunkHeight = std::min(CENSUS_CHUNK_SIZE, this->height - chunkTop);
+
+	for (int y = 0; y < chunkHeight; y++) {
+		std::uint16_t row = 0;
+		for (int x = 0; x < chunkWidth; x++) {
+			row += materialIndex(game.getMaterialType(chunkLeft + x, chunkTop + y)) == material;
+			table.sums[(y + 1) * stride + x + 1] = table.sums[y * stride + x + 1] + row;
+		}
+	}
+
+	table.material = static_cast<int>(material);
+	return table;
+}
@@ -0,0 +1,332 @@
+#include "MaterialTable.h"
+
+// STL
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace {
+	// Row order defines the index of every built-in material
+	const std::vector<MaterialInfo> BUILTIN_MATERIALS = {
+		//  type                   name          conductivity, capacity, exchange, spawn            phase transitions                                                               flammability
+		{ MaterialType::Empty,    "Empty",    { 0.05f, 1.0f, 0.02f, AMBIENT_TEMPERATURE }, { NO_TRANSITION_LOW, MaterialType::Empty,    NO_TRANSITION_HIGH, MaterialType::Empty    }, 0.00f },
+		{ MaterialType::Stone,    "Stone",    { 0.60f, 2.0f, 0.00f, AMBIENT_TEMPERATURE }, { NO_TRANSITION_LOW, MaterialType::Stone,    NO_TRANSITION_HIGH, MaterialType::Stone    }, 0.00f },
+		{ MaterialType::Brick,    "Brick",    { 0.40f, 2.0f, 0.00f, AMBIENT_TEMPERATURE }, { NO_TRANSITION_LOW, MaterialType::Brick,    NO_TRANSITION_HIGH, MaterialType::Brick    }, 0.00f },
+		{ MaterialType::Sand,     "Sand",     { 0.30f, 1.5f, 0.00f, AMBIENT_TEMPERATURE }, { NO_TRANSITION_LOW, MaterialType::Sand,     NO_TRANSITION_HIGH, MaterialType::Sand     }, 0.00f },
+		{ MaterialType::Dirt,     "Dirt",     { 0.25f, 1.5f, 0.00f, AMBIENT_TEMPERATURE }, { NO_TRANSITION_LOW, MaterialType::Dirt,     NO_TRANSITION_HIGH, MaterialType::Dirt     }, 0.00f },
+		{ MaterialType::Water,    "Water",    { 0.50f, 4.0f, 0.00f, AMBIENT_TEMPERATURE }, { NO_TRANSITION_LOW, MaterialType::Water,    100.0f,             MaterialType::Steam    }, 0.00f },
+		{ MaterialType::Oil,      "Oil",      { 0.30f, 2.0f, 0.00f, AMBIENT_TEMPERATURE }, { NO_TRANSITION_LOW, MaterialType::Oil,      250.0f,             MaterialType::Fire     }, 0.35f },
+		{ MaterialType::Lava,     "Lava",     { 0.80f, 3.0f, 0.00f, 1200.0f             }, { 600.0f,            MaterialType::Stone,    NO_TRANSITION_HIGH, MaterialType::Lava     }, 0.00f },
+		{ MaterialType::Smoke,    "Smoke",    { 0.10f, 1.0f, 0.01f, 60.0f               }, { NO_TRANSITION_LOW, MaterialType::Smoke,    NO_TRANSITION_HIGH, MaterialType::Smoke    }, 0.00f },
+		{ MaterialType::Steam,    "Steam",    { 0.20f, 1.0f, 0.01f, 110.0f              }, { 80.0f,             MaterialType::Water,    NO_TRANSITION_HIGH, MaterialType::Steam    }, 0.00f },
+		{ MaterialType::Fire,     "Fire",     { 0.30f, 1.0f, 0.05f, 800.0f              }, { NO_TRANSITION_LOW, MaterialType::Fire,     NO_TRANSITION_HIGH, MaterialType::Fire     }, 0.00f },
+		{ MaterialType::Vent,     "Vent",     { 0.50f, 2.0f, 0.00f, AMBIENT_TEMPERATURE }, { NO_TRANSITION_LOW, MaterialType::Vent,     NO_TRANSITION_HIGH, MaterialType::Vent     }, 0.00f },
+		{ MaterialType::Wire,     "Wire",     { 0.90f, 1.0f, 0.00f, AMBIENT_TEMPERATURE }, { NO_TRANSITION_LOW, MaterialType::Wire,     NO_TRANSITION_HIGH, MaterialType::Wire     }, 0.00f },
+		{ MaterialType::Battery,  "Battery",  { 0.40f, 2.0f, 0.00f, AMBIENT_TEMPERATURE }, { NO_TRANSITION_LOW, MaterialType::Battery,  NO_TRANSITION_HIGH, MaterialType::Battery  }, 0.00f },
+		{ MaterialType::Inverter, "Inverter", { 0.40f, 2.0f, 0.00f, AMBIENT_TEMPERATURE }, { NO_TRANSITION_LOW, MaterialType::Inverter, NO_TRANSITION_HIGH, MaterialType::Inverter }, 0.00f },
+		{ MaterialType::Plant,    "Plant",    { 0.30f, 3.0f, 0.00f, AMBIENT_TEMPERATURE }, { NO_TRANSITION_LOW, MaterialType::Plant,    180.0f,             MaterialType::Fire     }, 0.25f },
+	};
+
+	// Burning is generated from flammability by the reaction engine
+	const std::vector<ReactionRule> BUILTIN_REACTIONS = {
+		{ MaterialType::Water, MaterialType::Fire, MaterialType::Steam, MaterialType::Empty, 0.5f  },
+		{ MaterialType::Water, MaterialType::Lava, MaterialType::Steam, MaterialType::Stone, 0.05f },
+		{ MaterialType::Oil,   MaterialType::Lava, MaterialType::Fire,  MaterialType::Lava,  0.2f  },
+	};
+
+	std::vector<MaterialInfo> materialTable = BUILTIN_MATERIALS;
+	std::vector<ReactionRule> reactionRules = BUILTIN_REACTIONS;
+	std::vector<MaterialDefinition> definitions;
+
+	// === Definitions file parsing ===
+	struct PendingReaction {
+		std::string neighbor;
+		std::string selfProduct;
+		std::string neighborProduct;
+		float chance;
+		int line;
+	};
+
+	struct PendingMaterial {
+		MaterialInfo info;
+		MaterialDefinition definition;
+		std::string state;
+		std::string lowProduct;
+		std::string highProduct;
+		std::vector<PendingReaction> reactions;
+		int line;
+	};
+
+	std::string trim(const std::string& text)
+	{
+		std::size_t begin = text.find_first_not_of(" \t\r");
+		if (begin == std::string::npos) return "";
+		std::size_t end = text.find_last_not_of(" \t\r");
+		return text.substr(begin, end - begin + 1);
+	}
+
+	void warn(const std::string& path, int line, const std::string& message)
+	{
+		std::cerr << path << ":" << line << ": " << message << std::endl;
+	}
+
+	bool findByName(const std::string& name, MaterialType& type)
+	{
+		for (const MaterialInfo& info : materialTable) {
+			if (info.name == name) {
+				type = info.type;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	bool parseState(const std::string& state, MaterialState& result, float& density)
+	{
+		// Default densities match the base classes of the built-in materials
+		if (state == "solid")  { result = MaterialState::SolidUnmovable; density = 2200.0f; return true; }
+		if (state == "powder") { result = MaterialState::SolidMovable;   density = 1300.0f; return true; }
+		if (state == "liquid") { result = MaterialState::Liquid;         density = 1000.0f; return true; }
+		if (state == "gas")    { result = MaterialState::Gaseous;        density = 1.26f;   return true; }
+		return false;
+	}
+
+	bool parseColor(const std::string& text, std::uint32_t& color)
+	{
+		int r, g, b;
+		char comma1, comma2;
+		std::istringstream in(text);
+		if (!(in >> r >> comma1 >> g >> comma2 >> b) || comma1 != ',' || comma2 != ',')
+			return false;
+
+		color = (std::clamp(r, 0, 255) << 16) | (std::clamp(g, 0, 255) << 8) | std::clamp(b, 0, 255);
+		return true;
+	}
+
+	bool parseProperty(PendingMaterial& material, const std::string& key, const std::string& value, int line)
+	{
+		std::istringstream in(value);
+		MaterialInfo& info = material.info;
+		MaterialDefinition& definition = material.definition;
+
+		if (key == "state") return static_cast<bool>(in >> material.state);
+		if (key == "density") return static_cast<bool>(in >> definition.density);
+		if (key == "dispersion") return static_cast<bool>(in >> definition.dispersion);
+		if (key == "flammability") return static_cast<bool>(in >> info.flammability);
+		if (key == "spawn") return static_cast<bool>(in >> info.thermal.spawnTemperature);
+		if (key == "heat") {
+			if (!(in >> info.thermal.conductivity >> info.thermal.heatCapacity)) return false;
+			in >> info.thermal.ambientExchange;
+			info.thermal.heatCapacity = std::max(info.thermal.heatCapacity, 1.0f);
+			return true;
+		}
+		if (key == "above") return static_cast<bool>(in >> info.phase.highTemperature >> material.highProduct);
+		if (key == "below") return static_cast<bool>(in >> info.phase.lowTemperature >> material.lowProduct);
+		if (key == "key") {
+			std::string letter;
+			in >> letter;
+			if (letter.size() != 1 || !std::isalpha(static_cast<unsigned char>(letter[0]))) return false;
+			definition.key = static_cast<char>(std::toupper(static_cast<unsigned char>(letter[0])));
+			return true;
+		}
+		if (key == "colors") {
+			definition.palette.clear();
+			std::string token;
+			std::uint32_t color;
+			while (in >> token) {
+				if (!parseColor(token, color)) return false;
+				definition.palette.push_back(color);
+			}
+			return !definition.palette.empty();
+		}
+		if (key == "react") {
+			PendingReaction reaction;
+			if (!(in >> reaction.neighbor >> reaction.selfProduct >> reaction.neighborProduct >> reaction.chance))
+				return false;
+			reaction.line = line;
+			material.reactions.push_back(reaction);
+			return true;
+		}
+		return false;
+	}
+}
+
+std::array<std::uint8_t, MATERIAL_TYPE_SPACE> materialIndices = [] {
+	std::array<std::uint8_t, MATERIAL_TYPE_SPACE> indices{};
+	for (std::size_t i = 0; i < BUILTIN_MATERIALS.size(); i++)
+		indices[static_cast<uint16_t>(BUILTIN_MATERIALS[i].type)] = static_cast<std::uint8_t>(i);
+	return indices;
+	}();
+
+// === Lookup ===
+std::size_t getMaterialCount()
+{
+	return materialTable.size();
+}
+
+const MaterialInfo& getMaterialInfo(MaterialType type)
+{
+	return materialTable[materialIndex(type)];
+}
+
+const MaterialInfo& getMaterialInfoByIndex(std::size_t index)
+{
+	return materialTable[index];
+}
+
+const std::vector<ReactionRule>& getReactionRules()
+{
+	return reactionRules;
+}
+
+const std::vector<MaterialDefinition>& getMaterialDefinitions()
+{
+	return definitions;
+}
+
+const MaterialDefinition* findMaterialDefinition(MaterialType type)
+{
+	std::size_t index = materialIndex(type);
+	if (index < BUILTIN_MATERIALS.size()) return nullptr;
+	return &definitions[index - BUILTIN_MATERIALS.size()];
+}
+
+const MaterialDefinition* findMaterialDefinitionByKey(char key)
+{
+	for (const MaterialDefinition& definition : definitions)
+		if (definition.key == key)
+			return &definition;
+	return nullptr;
+}
+
+// === Loading ===
+bool loadMaterialDefinitions(const std::string& path)
+{
+	/*
+		@return bool - false if the file could not be opened
+
+		- read [Name] blocks of "key = value" lines
+		- give every material the next free index and MaterialType value
+		- resolve phase products and reactions by name, so materials may refer to later ones
+
+		Compiles the definitions file into the material table. Must run before the game
+		creates its simulation fields, they copy the table when they are constructed.
+		Lines with errors are reported and skipped.
+	*/
+
+	std::ifstream file(path);
+	if (!file.is_open()) return false;
+
+	// Forget materials of an earlier load
+	for (const MaterialDefinition& definition : definitions)
+		materialIndices[static_cast<uint16_t>(definition.type)] = 0;
+	materialTable.resize(BUILTIN_MATERIALS.size());
+	reactionRules = BUILTIN_REACTIONS;
+	definitions.clear();
+
+	std::vector<PendingMaterial> pending;
+	std::string text;
+	int line = 0;
+
+	while (std::getline(file, text)) {
+		line++;
+		text = trim(text.substr(0, text.find('#')));
+		if (text.empty()) continue;
+
+		if (text.front() == '[') {
+			if (text.back() != ']' || text.size() < 3) {
+				warn(path, line, "bad material header");
+				continue;
+			}
+
+			PendingMaterial material;
+			material.info = { MaterialType::Empty, trim(text.substr(1, text.size() - 2)),
+				{ 0.3f, 1.5f, 0.0f, AMBIENT_TEMPERATURE },
+				{ NO_TRANSITION_LOW, MaterialType::Empty, NO_TRANSITION_HIGH, MaterialType::Empty }, 0.0f };
+			material.definition = { MaterialType::Empty, material.info.name, -1.0f, -1.0f, {}, 0 };
+			material.line = line;
+			pending.push_back(material);
+			continue;
+		}
+
+		std::size_t separator = text.find('=');
+		if (pending.empty() || separator == std::string::npos) {
+			warn(path, line, "expected [Name] or key = value");
+			continue;
+		}
+
+		std::string key = trim(text.substr(0, separator));
+		if (!parseProperty(pending.back(), key, trim(text.substr(separator + 1)), line))
+			warn(path, line, "bad value for '" + key + "'");
+	}
+
+	// Give every valid material its index and type value
+	std::vector<const PendingMaterial*> accepted;
+	for (PendingMaterial& material : pending) {
+		MaterialState state;
+		float density;
+		MaterialType existing;
+
+		if (!parseState(material.state, state, density)) {
+			warn(path, material.line, "'" + material.info.name + "' needs state = solid, powder, liquid or gas");
+			continue;
+		}
+		if (findByName(material.info.name, existing)) {
+			warn(path, material.line, "'" + material.info.name + "' is already defined");
+			continue;
+		}
+		if (materialTable.size() >= MAX_MATERIAL_COUNT) {
+			warn(path, material.line, "too many materials");
+			break;
+		}
+
+		MaterialType type = static_cast<MaterialType>(static_cast<uint16_t>(state) | (DEFINED_INDEX_BASE + definitions.size()));
+		MaterialDefinition& definition = material.definition;
+		definition.type = type;
+		if (definition.key != 0 && std::strchr(RESERVED_MATERIAL_KEYS, definition.key)) {
+			warn(path, material.line, "'" + material.info.name + "' key " + definition.key + " is bound to a game command");
+			definition.key = 0;
+		}
+		if (definition.density < 0.0f) definition.density = density;
+		if (definition.palette.empty()) definition.palette.push_back(0x808080);
+
+		material.info.type = type;
+		material.info.phase.lowProduct = type;
+		material.info.phase.highProduct = type;
+
+		materialIndices[static_cast<uint16_t>(type)] = static_cast<std::uint8_t>(materialTable.size());
+		materialTable.push_back(material.info);
+		definitions.push_back(definition);
+		accepted.push_back(&material);
+	}
+
+	// Resolve names now that every material is known
+	for (const PendingMaterial* material : accepted) {
+		MaterialInfo& info = materialTable[materialIndex(material->info.type)];
+
+		if (!material->lowProduct.empty() && !findByName(material->lowProduct, info.phase.lowProduct)) {
+			warn(path, material->line, "unknown material '" + material->lowProduct + "'");
+			info.phase.lowTemperature = NO_TRANSITION_LOW;
+		}
+		if (!material->highProduct.empty() && !findByName(material->highProduct, info.phase.highProduct)) {
+			warn(path, material->line, "unknown material '" + material->highProduct + "'");
+			info.phase.highTemperature = NO_TRANSITION_HIGH;
+		}
+
+		for (const PendingReaction& reaction : material->reactions) {
+			ReactionRule rule = { info.type, MaterialType::Empty, MaterialType::Empty, MaterialType::Empty, reaction.chance };
+			if (!findByName(reaction.neighbor, rule.neighbor) ||
+				!findByName(reaction.selfProduct, rule.selfProduct) ||
+				!findByName(reaction.neighborProduct, rule.neighborProduct)) {
+				warn(path, reaction.line, "unknown material in reaction");
+				continue;
+			}
+			reactionRules.push_back(rule);
+		}
+	}
+
+	return true;
+}
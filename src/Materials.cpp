@@ -1,5 +1,9 @@
 ﻿#include "Materials.h"
 
+// STL
+#include <algorithm>
+#include <cmath>
+
 //////////////////////////    Material class     /////////////////////////
 
 Material::Material(MaterialType type, sf::Color color, float density)
@@ -24,6 +28,11 @@ float Material::getDensity() const
 	return this->density;
 }
 
+void Material::setColor(sf::Color color)
+{
+	this->color = color;
+}
+
 bool Material::isUpdated() const {
 	return this->updated;
 }
@@ -35,6 +44,16 @@ void Material::setUpdated(bool value) {
 //========================================================================
 
 
+//////////////////////////  BorderMaterial class  /////////////////////////
+
+BorderMaterial::BorderMaterial(MaterialType type)
+	: Material(type, DEFAULT_COLOR, 0.0f) { }
+
+void BorderMaterial::update(int x, int y, Game& game) { }
+
+//========================================================================
+
+
 //////////////////////////  SolidMaterial class  /////////////////////////
 
 SolidMaterial::SolidMaterial(MaterialType type, sf::Color color, float density)
@@ -63,21 +82,22 @@ void SolidMovableMaterial::update(int x, int y, Game& game)
 		int nx = x + dx;
 		int ny = y + dy;
 
-		if (!game.hasGameBorders() &&
-			!game.isValidPosition(nx, ny)) {
+		// The border around the grid makes this safe, a Wall sentinel matches none of the rules below
+		Material* target = game.getNeighbor(nx, ny);
+		MaterialType targetType = target->getType();
+
+		if (targetType == MaterialType::Void) {
 			game.setMaterialAt(MaterialType::Empty, x, y);
 			return true;
 		}
 
-		Material* target = game.getRawMaterial(nx, ny);
-		if (!target) return false;
-
+		bool isEmpty = targetType == MaterialType::Empty;
 		bool isLiquid = target->getState() == MaterialState::Liquid;
 		bool isGas = target->getState() == MaterialState::Gaseous;
 
 		// Down
 		if (ny > y) {
-			if (game.isEmpty(nx, ny) || isGas ||
+			if (isEmpty || isGas ||
 				(isLiquid && this->density > target->getDensity())) {
 				game.swapMaterials(x, y, nx, ny);
 				return true;
@@ -120,33 +140,37 @@ LiquidMaterial::LiquidMaterial(MaterialType type, sf::Color color, float density
 	: Material(type, color, density) { }
 
 void LiquidMaterial::update(int x, int y, Game& game) {
+	bool removed = false;  // moved into the void, this material no longer exists
+
 	auto tryMove = [&](int dx, int dy) -> bool {
 		int nx = x + dx;
 		int ny = y + dy;
 
-		if (!game.hasGameBorders() &&
-			!game.isValidPosition(nx, ny)) {
+		// Unchecked, see SolidMovableMaterial::update
+		Material* target = game.getNeighbor(nx, ny);
+		MaterialType targetType = target->getType();
+
+		if (targetType == MaterialType::Void) {
 			game.setMaterialAt(MaterialType::Empty, x, y);
+			removed = true;
 			return true;
 		}
 
-		Material* target = game.getRawMaterial(nx, ny);
-		if (!target) return false;
-
+		bool isEmpty = targetType == MaterialType::Empty;
 		bool isLiquid = target->getState() == MaterialState::Liquid;
 		bool isGas = target->getState() == MaterialState::Gaseous;
 
 		// Down
 		if (ny > y) {
-			if (game.isEmpty(nx, ny) || isGas ||
+			if (isEmpty || isGas ||
 				(isLiquid && this->density > target->getDensity())) {
 				game.swapMaterials(x, y, nx, ny);
 				return true;
 			}
 		}
-		// Sideway
+		// Sideway, swapping with the same liquid would change nothing but still wake the scene
 		else if (ny == y) {
-			if (isLiquid || isGas || game.isEmpty(nx, ny)) {
+			if ((isLiquid && targetType != this->getType()) || isGas || isEmpty) {
 				game.swapMaterials(x, y, nx, ny);
 				return true;
 			}
@@ -166,8 +190,9 @@ void LiquidMaterial::update(int x, int y, Game& game) {
 
 	if (tryMove(0, 1)) return;
 	if (tryMove(0, -1)) return;
-	for (int i = 1; i <= 10; i++)
-		if (tryMove(i * dir, 0)) continue;
+	int reach = std::min(this->dispersion, game.getDispersionLimit());
+	for (int i = 1; i <= reach; i++)
+		if (tryMove(i * dir, 0) && removed) return;
 }
 
 //========================================================================
@@ -180,32 +205,35 @@ GaseousMaterial::GaseousMaterial(MaterialType type, sf::Color color, float densi
 
 void GaseousMaterial::update(int x, int y, Game& game)
 {
+	if (game.skipsGasUpdate(x, y)) return;
+
 	auto tryMove = [&](int dx, int dy) -> bool {
 		int nx = x + dx;
 		int ny = y + dy;
 
-		if (!game.hasGameBorders() &&
-			!game.isValidPosition(nx, ny)) {
+		// Unchecked, see SolidMovableMaterial::update
+		Material* target = game.getNeighbor(nx, ny);
+		MaterialType targetType = target->getType();
+
+		if (targetType == MaterialType::Void) {
 			game.setMaterialAt(MaterialType::Empty, x, y);
 			return true;
 		}
 
-		Material* target = game.getRawMaterial(nx, ny);
-		if (!target) return false;
-
+		bool isEmpty = targetType == MaterialType::Empty;
 		bool isLiquid = target->getState() == MaterialState::Liquid;
 		bool isGas = target->getState() == MaterialState::Gaseous;
 
 		// Up
 		if (dy < 0) {
-			if ((isGas && this->density < target->getDensity()) || game.isEmpty(nx, ny)) {
+			if ((isGas && this->density < target->getDensity()) || isEmpty) {
 				game.swapMaterials(x, y, nx, ny);
 				return true;
 			}
 		}
 		// Side or down
 		else {
-			if (((isGas || isLiquid) && this->density < target->getDensity()) || game.isEmpty(nx, ny)) {
+			if (((isGas || isLiquid) && this->density < target->getDensity()) || isEmpty) {
 				game.swapMaterials(x, y, nx, ny);
 				return true;
 			}
@@ -214,29 +242,52 @@ void GaseousMaterial::update(int x, int y, Game& game)
 		return false;
 		};
 
-	static std::mt19937 rng(std::random_device{}());
-	std::uniform_int_distribution<int> offsetX(-1, 1);
-	std::uniform_int_distribution<int> offsetY(-1, 0);
+	// The wind field sets the direction; buoyancy keeps gases rising in still air
+	// and a little jitter keeps them dispersing
+	std::mt19937& rng = game.getRandom();
+	auto stochasticStep = [&](float velocity) -> int {
+		// Rounds up with a probability equal to the fractional part
+		float fraction = (rng() & 0xFFFF) / 65536.0f;
+		return std::clamp(static_cast<int>(std::floor(velocity + fraction)), -1, 1);
+		};
 
-	int dx = offsetX(rng);
-	int dy = offsetY(rng);
+	sf::Vector2f wind = game.getWindVelocity(x, y);
+	float jitter = ((rng() & 0xFFFF) / 32768.0f - 1.0f) * this->dispersion;
 
-	bool upFirst = rng() % 2;
+	int dx = stochasticStep(wind.x + jitter);
+	int dy = stochasticStep(wind.y - GAS_BUOYANCY);
 
-	// Main directions
-	if (upFirst) {
-		if (tryMove(dx, -1)) return;
-		if (tryMove(dx, 0)) return; 
-		if (tryMove(0, -1)) return; 
-	}
-	else {
-		if (tryMove(dx, 0)) return; 
-		if (tryMove(dx, -1)) return;
-		if (tryMove(0, -1)) return; 
+	if (dx == 0 && dy == 0) return;
+
+	// Main direction, then its components
+	if (tryMove(dx, dy)) return;
+	if (dx != 0 && dy != 0) {
+		if (tryMove(dx, 0)) return;
+		if (tryMove(0, dy)) return;
 	}
+}
+
+//========================================================================
 
-	// Attempted random displacement
-	if (tryMove(offsetX(rng), offsetY(rng))) return;
+
+/////////////////////////  DefinedMaterial class  ////////////////////////
+
+sf::Color pickPaletteColor(const MaterialDefinition& definition)
+{
+	static std::mt19937 rng(std::random_device{}());
+	std::uint32_t rgb = definition.palette[rng() % definition.palette.size()];
+
+	return sf::Color((rgb >> 16) & 0xFF, (rgb >> 8) & 0xFF, rgb & 0xFF);
+}
+
+std::unique_ptr<Material> createDefinedMaterial(const MaterialDefinition& definition)
+{
+	switch (static_cast<MaterialState>(static_cast<uint16_t>(definition.type) & (STATE_MASK | SOLID_TYPE_BIT))) {
+		case MaterialState::SolidMovable: return std::make_unique<DefinedMaterial<SolidMovableMaterial>>(definition);
+		case MaterialState::Liquid: return std::make_unique<DefinedMaterial<LiquidMaterial>>(definition);
+		case MaterialState::Gaseous: return std::make_unique<DefinedMaterial<GaseousMaterial>>(definition);
+		default: return std::make_unique<DefinedMaterial<SolidUnmovableMaterial>>(definition);
+	}
 }
 
 //========================================================================
@@ -286,6 +337,76 @@ sf::Color StoneMaterial::generateColor() const {
 //========================================================================
 
 
+///////////////////////////  VentMaterial class  //////////////////////////
+
+VentMaterial::VentMaterial(int x, int y)
+	: SolidUnmovableMaterial(MaterialType::Vent, generateColor(x, y), 7800.0f) { }
+
+sf::Color VentMaterial::generateColor(int x, int y) const {
+	// Horizontal grille slats
+	if (y % 2 == 0)
+		return sf::Color(95, 105, 115);
+	return sf::Color(40, 45, 52);
+}
+
+//========================================================================
+
+
+///////////////////////////  WireMaterial class  //////////////////////////
+
+WireMaterial::WireMaterial()
+	: SolidUnmovableMaterial(MaterialType::Wire, generateColor(), 8900.0f) { }
+
+sf::Color WireMaterial::generateColor() const {
+	return sf::Color(140, 82, 45);
+}
+
+//========================================================================
+
+
+//////////////////////////  BatteryMaterial class  ////////////////////////
+
+BatteryMaterial::BatteryMaterial()
+	: SolidUnmovableMaterial(MaterialType::Battery, generateColor()) { }
+
+sf::Color BatteryMaterial::generateColor() const {
+	return sf::Color(70, 170, 80);
+}
+
+//========================================================================
+
+
+/////////////////////////  InverterMaterial class  ////////////////////////
+
+InverterMaterial::InverterMaterial()
+	: SolidUnmovableMaterial(MaterialType::Inverter, generateColor()) { }
+
+sf::Color InverterMaterial::generateColor() const {
+	return sf::Color(120, 60, 150);
+}
+
+//========================================================================
+
+
+///////////////////////////  PlantMaterial class  /////////////////////////
+
+PlantMaterial::PlantMaterial()
+	: SolidUnmovableMaterial(MaterialType::Plant, generateColor(), 700.0f) { }
+
+sf::Color PlantMaterial::generateColor() const {
+	static std::mt19937 rng(std::random_device{}());
+	std::uniform_int_distribution<int> offset(-15, 15);
+
+	int r = std::clamp(40 + offset(rng), 0, 255);
+	int g = std::clamp(140 + offset(rng), 0, 255);
+	int b = std::clamp(45 + offset(rng), 0, 255);
+
+	return sf::Color(r, g, b);
+}
+
+//========================================================================
+
+
 //////////////////////////  DirtMaterial class  //////////////////////////
 
 DirtMaterial::DirtMaterial()
@@ -413,4 +534,79 @@ sf::Color SmokeMaterial::generateColor() const {
 	return sf::Color(shade, shade, shade);
 }
 
+//========================================================================
+
+
+///////////////////////////  LavaMaterial class  //////////////////////////
+
+LavaMaterial::LavaMaterial()
+	: LiquidMaterial(MaterialType::Lava, generateColor(), 2600.0f) { }
+
+sf::Color LavaMaterial::generateColor() const {
+	static std::mt19937 rng(std::random_device{}());
+	std::uniform_int_distribution<int> offset(-15, 15);
+
+	int r = std::clamp(207 + offset(rng), 0, 255);
+	int g = std::clamp(70 + offset(rng), 0, 255);
+	int b = std::clamp(16 + offset(rng) / 3, 0, 255);
+
+	return sf::Color(r, g, b);
+}
+
+//========================================================================
+
+
+//////////////////////////  SteamMaterial class  /////////////////////////
+
+SteamMaterial::SteamMaterial()
+	: GaseousMaterial(MaterialType::Steam, generateColor(), 0.6f) { }
+
+sf::Color SteamMaterial::generateColor() const {
+	static std::random_device rd;
+	static std::mt19937 gen(rd());
+	int shade = 170 + gen() % 25;
+	return sf::Color(shade, shade, shade + 10);
+}
+
+//========================================================================
+
+
+///////////////////////////  FireMaterial class  //////////////////////////
+
+FireMaterial::FireMaterial()
+	: GaseousMaterial(MaterialType::Fire, generateColor(), 0.3f)
+{
+	static std::mt19937 rng(std::random_device{}());
+	this->lifetime = 20 + rng() % 40;
+}
+
+void FireMaterial::update(int x, int y, Game& game)
+{
+	if (this->expire(x, y, game))
+		return;
+
+	GaseousMaterial::update(x, y, game);
+}
+
+bool FireMaterial::expire(int x, int y, Game& game)
+{
+	if (--this->lifetime > 0)
+		return false;
+
+	// Burnt out flames leave some smoke behind
+	game.setMaterialAt(game.getRandom()() % 3 == 0 ? MaterialType::Smoke : MaterialType::Empty, x, y);
+	return true;
+}
+
+sf::Color FireMaterial::generateColor() const {
+	static std::mt19937 rng(std::random_device{}());
+	std::uniform_int_distribution<int> offset(-20, 20);
+
+	int r = std::clamp(240 + offset(rng), 0, 255);
+	int g = std::clamp(120 + offset(rng) * 2, 0, 255);
+	int b = std::clamp(30 + offset(rng), 0, 255);
+
+	return sf::Color(r, g, b);
+}
+
 //========================================================================
\ No newline at end of file
@@ -0,0 +1,194 @@
+#include "Minimap.h"
+
+// Project headers
+#include "Tracer.h"
+
+// STL
+#include <algorithm>
+
+// === Constructors ===
+Minimap::Minimap()
+{
+	this->border.setFillColor(sf::Color::Transparent);
+	this->border.setOutlineColor(MINIMAP_FRAME_COLOR);
+	this->border.setOutlineThickness(1.0f);
+}
+
+// === Accessors ===
+int Minimap::getColumns() const
+{
+	return this->columns;
+}
+
+int Minimap::getRows() const
+{
+	return this->rows;
+}
+
+std::size_t Minimap::getActiveCount() const
+{
+	return this->activeChunks.size();
+}
+
+const std::vector<int>& Minimap::getDirtyChunks() const
+{
+	/*
+		@return const std::vector<int>& - chunks changed since the last update, row major over getColumns()
+	*/
+
+	return this->dirtyChunks;
+}
+
+// === Grid hooks ===
+void Minimap::markColumnChanged(int x, int top, int bottom)
+{
+	for (int y = top & ~(MINIMAP_CHUNK_SIZE - 1); y <= bottom; y += MINIMAP_CHUNK_SIZE)
+		this->markChanged(x, y);
+}
+
+void Minimap::markAll()
+{
+	for (int y = 0; y < this->height; y += MINIMAP_CHUNK_SIZE)
+		for (int x = 0; x < this->width; x += MINIMAP_CHUNK_SIZE)
+			this->markChanged(x, y);
+}
+
+// === Methods ===
+void Minimap::resize(int width, int height)
+{
+	/*
+		@return void
+
+		Starts an empty map for a grid of width x height cells, every chunk is summarized on the next update
+	*/
+
+	this->width = width;
+	this->height = height;
+	this->columns = (width + MINIMAP_CHUNK_SIZE - 1) / MINIMAP_CHUNK_SIZE;
+	this->rows = (height + MINIMAP_CHUNK_SIZE - 1) / MINIMAP_CHUNK_SIZE;
+
+	std::size_t chunkCount = static_cast<std::size_t>(this->columns) * this->rows;
+	this->dirty.assign(chunkCount, 0);
+	this->dirtyChunks.clear();
+	this->active.assign(chunkCount, 0);
+	this->activeChunks.clear();
+	this->lastChange.assign(chunkCount, 0);
+	this->summaries.assign(chunkCount, sf::Color::Black);
+	this->pixels.assign(chunkCount * 4, 0);
+
+	this->texture.create(this->columns, this->rows);
+	this->sprite.setTexture(this->texture, true);
+	this->markAll();
+}
+
+void Minimap::update(const sf::VertexArray& vertices)
+{
+	/*
+		@return void
+
+		- summarize the chunks changed since the last update from the vertex colors
+		- dim the chunks that stopped changing
+		- upload the texture if any pixel changed
+
+		vertices is the vertex grid, its colors must be up to date.
+	*/
+
+	TRACE_SCOPE("Minimap::update");
+
+	this->frame++;
+
+	for (int chunk : this->dirtyChunks) {
+		this->dirty[chunk] = 0;
+		this->lastChange[chunk] = this->frame;
+		this->summarize(chunk, vertices);
+
+		if (!this->active[chunk]) {
+			this->active[chunk] = 1;
+			this->activeChunks.push_back(chunk);
+		}
+		this->shade(chunk);
+	}
+	this->dirtyChunks.clear();
+
+	for (std::size_t i = 0; i < this->activeChunks.size();) {
+		int chunk = this->activeChunks[i];
+		if (this->frame - this->lastChange[chunk] <= MINIMAP_ACTIVE_FRAMES) {
+			i++;
+			continue;
+		}
+
+		this->active[chunk] = 0;
+		this->shade(chunk);
+		this->activeChunks[i] = this->activeChunks.back();
+		this->activeChunks.pop_back();
+	}
+
+	if (this->pixelsChanged) {
+		this->texture.update(this->pixels.data());
+		this->pixelsChanged = false;
+	}
+}
+
+void Minimap::place(const sf::Vector2f& position, float width)
+{
+	/*
+		@return void
+
+		Puts the top left corner of the map at position and scales it to width pixels, keeping the grid aspect
+	*/
+
+	if (this->columns == 0) return;
+
+	float scale = width / this->columns;
+	this->sprite.setPosition(position);
+	this->sprite.setScale(scale, scale);
+	this->border.setPosition(position);
+	this->border.setSize(sf::Vector2f(width, this->rows * scale));
+}
+
+void Minimap::draw(sf::RenderWindow& window) const
+{
+	window.draw(this->sprite);
+	window.draw(this->border);
+}
+
+// === Private ===
+void Minimap::summarize(int chunk, const sf::VertexArray& vertices)
+{
+	// Average color of the cells in the chunk, edge chunks may be cut by the grid
+	int left = (chunk % this->columns) * MINIMAP_CHUNK_SIZE;
+	int top = (chunk / this->columns) * MINIMAP_CHUNK_SIZE;
+	int right = std::min(left + MINIMAP_CHUNK_SIZE, this->width);
+	int bottom = std::min(top + MINIMAP_CHUNK_SIZE, this->height);
+
+	unsigned int r = 0, g = 0, b = 0;
+	for (int y = top; y < bottom; y++) {
+		for (int x = left; x < right; x++) {
+			const sf::Color& color = vertices[(x + y * this->width) * 4].color;
+			r += color.r;
+			g += color.g;
+			b += color.b;
+		}
+	}
+
+	unsigned int count = (right - left) * (bottom - top);
+	this->summaries[chunk] = sf::Color(r / count, g / count, b / count);
+}
+
+void Minimap::shade(int chunk)
+{
+	// Tinted while the chunk is active, dimmed once it is asleep
+	sf::Color color = this->summaries[chunk];
+	auto mix = [&](sf::Uint8 value, sf::Uint8 tint) -> sf::Uint8 {
+		if (this->active[chunk])
+			return static_cast<sf::Uint8>(value + (tint - value) * MINIMAP_ACTIVE_TINT);
+		return static_cast<sf::Uint8>(value * MINIMAP_SLEEP_SHADE);
+		};
+
+	sf::Uint8* pixel = &this->pixels[static_cast<std::size_t>(chunk) * 4];
+	pixel[0] = mix(color.r, MINIMAP_ACTIVE_COLOR.r);
+	pixel[1] = mix(color.g, MINIMAP_ACTIVE_COLOR.g);
+	pixel[2] = mix(color.b, MINIMAP_ACTIVE_COLOR.b);
+	pixel[3] = 255;
+	this->pixelsChanged = true;
+}
@@ -0,0 +1,157 @@
+#include "OccupancyMap.h"
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace {
+	// Both helpers expect a non-zero word
+	int countTrailingZeros(std::uint64_t word)
+	{
+#ifdef _MSC_VER
+		unsigned long index;
+		_BitScanForward64(&index, word);
+		return static_cast<int>(index);
+#else
+		return __builtin_ctzll(word);
+#endif
+	}
+
+	int highestBit(std::uint64_t word)
+	{
+#ifdef _MSC_VER
+		unsigned long index;
+		_BitScanReverse64(&index, word);
+		return static_cast<int>(index);
+#else
+		return 63 - __builtin_clzll(word);
+#endif
+	}
+}
+
+// === Constructors ===
+OccupancyMap::OccupancyMap() { }
+
+// === Accessors ===
+bool OccupancyMap::isOccupied(int x, int y) const
+{
+	return this->getBit(this->occupied, x, y);
+}
+
+bool OccupancyMap::isMovable(int x, int y) const
+{
+	return this->getBit(this->movable, x, y);
+}
+
+bool OccupancyMap::hasMovable(int y) const
+{
+	return this->movableCounts[y] > 0;
+}
+
+int OccupancyMap::nextMovable(int x, int y) const
+{
+	/*
+		@return int
+
+		First movable cell at or after x in row y, or the grid width if there is none.
+	*/
+
+	if (x >= this->width) return this->width;
+
+	const std::uint64_t* row = &this->movable[static_cast<std::size_t>(y) * this->wordsPerRow];
+	int word = x >> 6;
+	std::uint64_t bits = row[word] & (~0ull << (x & 63));
+
+	while (!bits) {
+		if (++word == this->wordsPerRow) return this->width;
+		bits = row[word];
+	}
+	return (word << 6) + countTrailingZeros(bits);
+}
+
+int OccupancyMap::previousMovable(int x, int y) const
+{
+	/*
+		@return int
+
+		First movable cell at or before x in row y, or -1 if there is none.
+	*/
+
+	if (x < 0) return -1;
+
+	const std::uint64_t* row = &this->movable[static_cast<std::size_t>(y) * this->wordsPerRow];
+	int word = x >> 6;
+	std::uint64_t bits = row[word] & (~0ull >> (63 - (x & 63)));
+
+	while (!bits) {
+		if (--word < 0) return -1;
+		bits = row[word];
+	}
+	return (word << 6) + highestBit(bits);
+}
+
+// === Grid sync ===
+void OccupancyMap::resize(int width, int height)
+{
+	this->width = width;
+	this->height = height;
+	this->wordsPerRow = (width + 63) / 64;
+
+	std::size_t size = static_cast<std::size_t>(this->wordsPerRow) * height;
+	this->occupied.assign(size, 0);
+	this->movable.assign(size, 0);
+	this->movableCounts.assign(height, 0);
+}
+
+void OccupancyMap::setMaterial(int x, int y, MaterialType type)
+{
+	bool wasMovable = this->isMovable(x, y);
+	bool isMovable = hasUpdateRule(type);
+
+	if (wasMovable != isMovable)
+		this->movableCounts[y] += isMovable ? 1 : -1;
+
+	this->setBit(this->occupied, x, y, type != MaterialType::Empty);
+	this->setBit(this->movable, x, y, isMovable);
+}
+
+void OccupancyMap::swapCells(int x1, int y1, int x2, int y2)
+{
+	bool occupied1 = this->isOccupied(x1, y1);
+	bool occupied2 = this->isOccupied(x2, y2);
+	bool movable1 = this->isMovable(x1, y1);
+	bool movable2 = this->isMovable(x2, y2);
+
+	this->setBit(this->occupied, x1, y1, occupied2);
+	this->setBit(this->occupied, x2, y2, occupied1);
+
+	if (movable1 != movable2) {
+		this->setBit(this->movable, x1, y1, movable2);
+		this->setBit(this->movable, x2, y2, movable1);
+		this->movableCounts[y1] += movable2 ? 1 : -1;
+		this->movableCounts[y2] += movable1 ? 1 : -1;
+	}
+}
+
+// === Private ===
+bool OccupancyMap::hasUpdateRule(MaterialType type)
+{
+	// Unmovable solids (Empty included) never change on their own
+	return static_cast<MaterialState>(static_cast<uint16_t>(type) & (STATE_MASK | SOLID_TYPE_BIT)) != MaterialState::SolidUnmovable;
+}
+
+void OccupancyMap::setBit(std::vector<std::uint64_t>& bits, int x, int y, bool value)
+{
+	std::uint64_t& word = bits[static_cast<std::size_t>(y) * this->wordsPerRow + (x >> 6)];
+	std::uint64_t mask = 1ull << (x & 63);
+
+	if (value)
+		word |= mask;
+	else
+		word &= ~mask;
+}
+
+bool OccupancyMap::getBit(const std::vector<std::uint64_t>& bits, int x, int y) const
+{
+	return (bits[static_cast<std::size_t>(y) * this->wordsPerRow + (x >> 6)] >> (x & 63)) & 1;
+}
@@ -0,0 +1,228 @@
+#include "PerfCounters.h"
+
+// STL
+#include <cerrno>
+#include <cstring>
+
+#ifdef __linux__
+// Linux
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace {
+	const char* EVENT_NAMES[PERF_EVENT_COUNT] = { "cycles", "instructions", "L1 misses", "LLC misses", "branch misses" };
+	const char* REGION_NAMES[PERF_REGION_COUNT] = { "grid update", "color build" };
+
+#ifdef __linux__
+	// Type and config of every PerfEvent, in enum order
+	const std::uint32_t EVENT_TYPES[PERF_EVENT_COUNT] = {
+		PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HW_CACHE, PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE
+	};
+	const std::uint64_t EVENT_CONFIGS[PERF_EVENT_COUNT] = {
+		PERF_COUNT_HW_CPU_CYCLES,
+		PERF_COUNT_HW_INSTRUCTIONS,
+		PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16),
+		PERF_COUNT_HW_CACHE_MISSES,
+		PERF_COUNT_HW_BRANCH_MISSES
+	};
+
+	int openEvent(std::size_t event, int groupFd)
+	{
+		perf_event_attr attr;
+		std::memset(&attr, 0, sizeof(attr));
+		attr.size = sizeof(attr);
+		attr.type = EVENT_TYPES[event];
+		attr.config = EVENT_CONFIGS[event];
+		attr.disabled = groupFd < 0;  // the leader starts the whole group
+		attr.exclude_kernel = 1;        // user space only, allowed at the default paranoid level
+		attr.exclude_hv = 1;
+		attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+		// This thread, any CPU
+		return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, groupFd, 0));
+	}
+#endif
+}
+
+// === Constructors ===
+PerfCounters::PerfCounters()
+{
+	this->fds.fill(-1);
+	this->positions.fill(-1);
+}
+
+PerfCounters::~PerfCounters()
+{
+	this->close();
+}
+
+// === Accessors ===
+bool PerfCounters::isOpen() const
+{
+	return this->groupFd >= 0;
+}
+
+bool PerfCounters::hasEvent(PerfEvent event) const
+{
+	return this->positions[static_cast<std::size_t>(event)] >= 0;
+}
+
+const std::string& PerfCounters::getError() const
+{
+	return this->error;
+}
+
+int PerfCounters::getTickCount() const
+{
+	return this->ticks;
+}
+
+const PerfReading& PerfCounters::getTickReading(PerfRegion region) const
+{
+	return this->tickReadings[static_cast<std::size_t>(region)];
+}
+
+const PerfReading& PerfCounters::getTotalReading(PerfRegion region) const
+{
+	return this->totalReadings[static_cast<std::size_t>(region)];
+}
+
+const char* PerfCounters::getEventName(PerfEvent event)
+{
+	return EVENT_NAMES[static_cast<std::size_t>(event)];
+}
+
+const char* PerfCounters::getRegionName(PerfRegion region)
+{
+	return REGION_NAMES[static_cast<std::size_t>(region)];
+}
+
+// === Methods ===
+bool PerfCounters::open()
+{
+	/*
+		@return bool - false if no counter could be opened, getError() tells why
+
+		Opens the counters as one group, so they are always scheduled together and
+		their ratios stay meaningful. Events the CPU does not support are skipped.
+	*/
+
+	this->close();
+
+#ifdef __linux__
+	for (std::size_t event = 0; event < PERF_EVENT_COUNT; event++) {
+		int fd = openEvent(event, this->groupFd);
+		if (fd < 0) {
+			if (this->groupFd < 0)
+				this->error = std::strerror(errno);
+			continue;
+		}
+
+		if (this->groupFd < 0)
+			this->groupFd = fd;
+		this->fds[event] = fd;
+		this->positions[event] = this->openCount++;
+	}
+
+	if (this->groupFd < 0) {
+		this->error = "perf_event_open failed: " + this->error;
+		return false;
+	}
+
+	ioctl(this->groupFd, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+	ioctl(this->groupFd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+	this->error.clear();
+	return true;
+#else
+	this->error = "hardware counters are only available on Linux";
+	return false;
+#endif
+}
+
+void PerfCounters::close()
+{
+#ifdef __linux__
+	for (int& fd : this->fds) {
+		if (fd >= 0)
+			::close(fd);
+		fd = -1;
+	}
+#endif
+
+	this->groupFd = -1;
+	this->positions.fill(-1);
+	this->openCount = 0;
+	this->tickReadings.fill(PerfReading());
+	this->totalReadings.fill(PerfReading());
+	this->ticks = 0;
+}
+
+void PerfCounters::beginTick()
+{
+	if (!this->isOpen()) return;
+
+	this->tickReadings.fill(PerfReading());
+	this->ticks++;
+}
+
+void PerfCounters::beginRegion()
+{
+	if (this->isOpen())
+		this->read(this->start);
+}
+
+void PerfCounters::endRegion(PerfRegion region)
+{
+	/*
+		@return void
+
+		Adds the counts since beginRegion to the region, for this tick and in total.
+		Counts are scaled up for the share of the region the group was not scheduled.
+	*/
+
+	if (!this->isOpen()) return;
+
+	Snapshot end;
+	if (!this->read(end)) return;
+
+	std::uint64_t enabled = end.enabled - this->start.enabled;
+	std::uint64_t running = end.running - this->start.running;
+	if (running == 0) return;
+
+	double scale = static_cast<double>(enabled) / running;
+	PerfReading& tick = this->tickReadings[static_cast<std::size_t>(region)];
+	PerfReading& total = this->totalReadings[static_cast<std::size_t>(region)];
+
+	for (std::size_t event = 0; event < PERF_EVENT_COUNT; event++) {
+		std::uint64_t count = static_cast<std::uint64_t>((end.values[event] - this->start.values[event]) * scale);
+		tick.values[event] += count;
+		total.values[event] += count;
+	}
+}
+
+// === Private ===
+bool PerfCounters::read(Snapshot& snapshot) const
+{
+	/*
+		@return bool - false if the group could not be read
+	*/
+
+#ifdef __linux__
+	// nr, time enabled, time running, then one value per counter
+	std::uint64_t data[3 + PERF_EVENT_COUNT];
+	ssize_t size = ::read(this->groupFd, data, sizeof(data));
+	if (size < static_cast<ssize_t>((3 + this->openCount) * sizeof(std::uint64_t)))
+		return false;
+
+	snapshot.enabled = data[1];
+	snapshot.running = data[2];
+	for (std::size_t event = 0; event < PERF_EVENT_COUNT; event++)
+		snapshot.values[event] = this->positions[event] >= 0 ? data[3 + this->positions[event]] : 0;
+	return true;
+#else
+	return false;
+#endif
+}
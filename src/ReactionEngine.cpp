@@ -0,0 +1,139 @@
+#include "ReactionEngine.h"
+
+// Project headers
+#include "Game.h"
+#include "Tracer.h"
+
+// STL
+#include <algorithm>
+
+// === Constructors ===
+ReactionEngine::ReactionEngine()
+{
+	this->materialCount = getMaterialCount();
+	this->matrix.assign(this->materialCount * this->materialCount, { MaterialType::Empty, MaterialType::Empty, 0 });
+	this->reactive.assign(this->materialCount, 0);
+
+	// Burning spreads only into materials the table marks as flammable
+	for (std::size_t i = 0; i < this->materialCount; i++) {
+		const MaterialInfo& info = getMaterialInfoByIndex(i);
+		if (info.flammability > 0.0f)
+			this->addReaction(info.type, MaterialType::Fire, MaterialType::Fire, MaterialType::Smoke, info.flammability);
+	}
+
+	for (const ReactionRule& rule : getReactionRules())
+		this->addReaction(rule.self, rule.neighbor, rule.selfProduct, rule.neighborProduct, rule.chance);
+}
+
+// === Accessors ===
+std::size_t ReactionEngine::getActiveCount() const
+{
+	return this->active.size();
+}
+
+bool ReactionEngine::isIdle() const
+{
+	return this->active.empty();
+}
+
+// === Grid sync ===
+void ReactionEngine::resize(int width, int height)
+{
+	this->width = width;
+	this->height = height;
+	this->active.clear();
+	this->processing.clear();
+	this->queued.assign(static_cast<std::size_t>(width) * height, 0);
+}
+
+void ReactionEngine::track(int x, int y, MaterialType type)
+{
+	/*
+		@return void
+
+		Queues a cell that was just placed or moved. Only materials that appear
+		in the matrix are queued, everything else costs a single table read.
+	*/
+
+	if (!this->reactive[materialIndex(type)])
+		return;
+
+	int i = y * this->width + x;
+	if (this->queued[i]) return;
+
+	this->queued[i] = 1;
+	this->active.push_back(i);
+}
+
+// === Main logic ===
+void ReactionEngine::update(Game& game)
+{
+	/*
+		@return void
+
+		- take the queued cells
+		- look up every neighbour pair in the matrix
+		- keep cells that still have a partner next to them
+
+		Applies one tick of reactions. Cells without a reaction partner drop out
+		of the queue until they move or a neighbour changes.
+	*/
+
+	TRACE_SCOPE("Reactions");
+
+	static const int offsets[4][2] = { { 0, 1 }, { 0, -1 }, { -1, 0 }, { 1, 0 } };
+
+	this->processing.swap(this->active);
+	this->active.clear();
+
+	for (int i : this->processing)
+		this->queued[i] = 0;
+
+	std::mt19937& rng = game.getRandom();
+
+	for (int i : this->processing) {
+		int x = i % this->width;
+		int y = i / this->width;
+
+		MaterialType type = game.getMaterialType(x, y);
+		std::size_t row = materialIndex(type) * this->materialCount;
+		if (!this->reactive[materialIndex(type)])
+			continue;
+
+		bool hasPartner = false;
+		for (const auto& offset : offsets) {
+			int nx = x + offset[0];
+			int ny = y + offset[1];
+			if (!game.isValidPosition(nx, ny)) continue;
+
+			const Reaction& reaction = this->matrix[row + materialIndex(game.getMaterialType(nx, ny))];
+			if (reaction.threshold == 0) continue;
+
+			hasPartner = true;
+			if (rng() >= reaction.threshold) continue;
+
+			game.setMaterialAt(reaction.neighborProduct, nx, ny);
+			game.setMaterialAt(reaction.selfProduct, x, y);
+			break;
+		}
+
+		// Products are queued by setMaterialAt, an unreacted cell waits for its partner
+		if (hasPartner)
+			this->track(x, y, game.getMaterialType(x, y));
+	}
+}
+
+// === Private ===
+void ReactionEngine::addReaction(MaterialType self, MaterialType neighbor,
+	MaterialType selfProduct, MaterialType neighborProduct, float chance)
+{
+	std::uint32_t threshold = static_cast<std::uint32_t>(std::min(chance, 0.999f) * 4294967296.0);
+	std::size_t a = materialIndex(self);
+	std::size_t b = materialIndex(neighbor);
+
+	// Stored from both sides so whichever cell is visited finds the rule
+	this->matrix[a * this->materialCount + b] = { selfProduct, neighborProduct, threshold };
+	this->matrix[b * this->materialCount + a] = { neighborProduct, selfProduct, threshold };
+	this->reactive[a] = 1;
+	this->reactive[b] = 1;
+}
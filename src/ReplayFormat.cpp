@@ -0,0 +1,161 @@
+#include "ReplayFormat.h"
+
+// STL
+#include <algorithm>
+
+namespace {
+	void writeValue(std::vector<std::uint8_t>& out, ReplayPalette& palette, std::uint32_t value)
+	{
+		auto found = palette.codes.find(value);
+		if (found != palette.codes.end()) {
+			writeVarint(out, found->second);
+			return;
+		}
+
+		palette.values.push_back(value);
+		palette.codes.emplace(value, static_cast<std::uint32_t>(palette.values.size()));
+
+		out.push_back(0);
+		out.push_back(static_cast<std::uint8_t>(value));
+		out.push_back(static_cast<std::uint8_t>(value >> 8));
+		out.push_back(static_cast<std::uint8_t>(value >> 16));
+		out.push_back(static_cast<std::uint8_t>(value >> 24));
+	}
+
+	bool readValue(const std::uint8_t*& data, const std::uint8_t* end, ReplayPalette& palette, std::uint32_t& value)
+	{
+		std::uint64_t code;
+		if (!readVarint(data, end, code)) return false;
+
+		if (code > 0) {
+			if (code > palette.values.size()) return false;
+			value = palette.values[code - 1];
+			return true;
+		}
+
+		if (end - data < 4) return false;
+		value = data[0] | (data[1] << 8) | (data[2] << 16) | (static_cast<std::uint32_t>(data[3]) << 24);
+		data += 4;
+		palette.values.push_back(value);
+		return true;
+	}
+
+	// Run-length encodes cells[begin, end)
+	void writeRuns(std::vector<std::uint8_t>& out, ReplayPalette& palette, const std::vector<std::uint32_t>& cells,
+		std::size_t begin, std::size_t end)
+	{
+		while (begin < end) {
+			std::size_t run = begin + 1;
+			while (run < end && cells[run] == cells[begin])
+				run++;
+
+			writeVarint(out, run - begin);
+			writeValue(out, palette, cells[begin]);
+			begin = run;
+		}
+	}
+
+	bool readRuns(const std::uint8_t*& data, const std::uint8_t* end, ReplayPalette& palette,
+		std::vector<std::uint32_t>& cells, std::size_t begin, std::size_t count)
+	{
+		while (count > 0) {
+			std::uint64_t run;
+			std::uint32_t value;
+			if (!readVarint(data, end, run) || !readValue(data, end, palette, value) || run == 0 || run > count)
+				return false;
+
+			std::fill(cells.begin() + begin, cells.begin() + begin + run, value);
+			begin += run;
+			count -= run;
+		}
+		return true;
+	}
+}
+
+// === Primitives ===
+void writeVarint(std::vector<std::uint8_t>& out, std::uint64_t value)
+{
+	while (value >= 0x80) {
+		out.push_back(static_cast<std::uint8_t>(value | 0x80));
+		value >>= 7;
+	}
+	out.push_back(static_cast<std::uint8_t>(value));
+}
+
+bool readVarint(const std::uint8_t*& data, const std::uint8_t* end, std::uint64_t& value)
+{
+	value = 0;
+	for (int shift = 0; shift < 64 && data < end; shift += 7) {
+		std::uint8_t byte = *data++;
+		value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+		if (!(byte & 0x80)) return true;
+	}
+	return false;
+}
+
+// === Records ===
+void encodeKeyframe(const std::vector<std::uint32_t>& cells, ReplayPalette& palette, std::vector<std::uint8_t>& out)
+{
+	out.clear();
+	palette.clear();
+	writeRuns(out, palette, cells, 0, cells.size());
+}
+
+void encodeDelta(const std::vector<std::uint32_t>& previous, const std::vector<std::uint32_t>& cells,
+	ReplayPalette& palette, std::vector<std::uint8_t>& out)
+{
+	/*
+		@return void
+
+		Writes the cells that differ from the previous tick as runs of changed cells.
+		An unchanged tick encodes to nothing.
+	*/
+
+	out.clear();
+
+	std::size_t size = cells.size();
+	std::size_t last = 0;
+	std::size_t i = 0;
+
+	while (i < size) {
+		if (cells[i] == previous[i]) {
+			i++;
+			continue;
+		}
+
+		std::size_t begin = i;
+		while (i < size && cells[i] != previous[i])
+			i++;
+
+		writeVarint(out, begin - last);
+		writeVarint(out, i - begin);
+		writeRuns(out, palette, cells, begin, i);
+		last = i;
+	}
+}
+
+bool decodeKeyframe(const std::vector<std::uint8_t>& payload, ReplayPalette& palette, std::vector<std::uint32_t>& cells)
+{
+	const std::uint8_t* data = payload.data();
+	palette.clear();
+	return readRuns(data, data + payload.size(), palette, cells, 0, cells.size());
+}
+
+bool decodeDelta(const std::vector<std::uint8_t>& payload, ReplayPalette& palette, std::vector<std::uint32_t>& cells)
+{
+	const std::uint8_t* data = payload.data();
+	const std::uint8_t* end = data + payload.size();
+	std::size_t position = 0;
+
+	while (data < end) {
+		std::uint64_t skip, length;
+		if (!readVarint(data, end, skip) || !readVarint(data, end, length))
+			return false;
+
+		position += skip;
+		if (position + length > cells.size() || !readRuns(data, end, palette, cells, position, length))
+			return false;
+		position += length;
+	}
+	return true;
+}
@@ -0,0 +1,140 @@
+#include "ReplayPlayer.h"
+
+// STL
+#include <algorithm>
+#include <cstring>
+
+namespace {
+	bool readStreamVarint(std::ifstream& file, std::uint64_t& value)
+	{
+		value = 0;
+		for (int shift = 0; shift < 64; shift += 7) {
+			int byte = file.get();
+			if (byte == EOF) return false;
+			value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+			if (!(byte & 0x80)) return true;
+		}
+		return false;
+	}
+}
+
+// === Constructors ===
+ReplayPlayer::ReplayPlayer() { }
+
+// === Accessors ===
+int ReplayPlayer::getWidth() const
+{
+	return this->width;
+}
+
+int ReplayPlayer::getHeight() const
+{
+	return this->height;
+}
+
+int ReplayPlayer::getTick() const
+{
+	return this->tick;
+}
+
+int ReplayPlayer::getTickCount() const
+{
+	return static_cast<int>(this->offsets.size());
+}
+
+const std::vector<std::uint32_t>& ReplayPlayer::getCells() const
+{
+	return this->cells;
+}
+
+// === Methods ===
+bool ReplayPlayer::open(const std::string& path)
+{
+	/*
+		@return bool - false if the file is missing, not a replay or has no keyframe
+
+		Reads the header and indexes every record. A record cut short at the end of the
+		file (a recording that was not closed) is ignored.
+	*/
+
+	this->file.open(path, std::ios::binary);
+	if (!this->file.is_open()) return false;
+
+	char magic[sizeof(REPLAY_MAGIC)];
+	std::uint64_t width, height;
+	if (!this->file.read(magic, sizeof(magic)) || std::memcmp(magic, REPLAY_MAGIC, sizeof(magic)) != 0 ||
+		this->file.get() != REPLAY_VERSION ||
+		!readStreamVarint(this->file, width) || !readStreamVarint(this->file, height) ||
+		width == 0 || height == 0)
+		return false;
+
+	this->width = static_cast<int>(width);
+	this->height = static_cast<int>(height);
+
+	std::uint64_t recordsStart = this->file.tellg();
+	this->file.seekg(0, std::ios::end);
+	std::uint64_t fileSize = this->file.tellg();
+	this->file.seekg(recordsStart);
+
+	while (true) {
+		int type = this->file.get();
+		std::uint64_t size;
+		if (type == EOF || !readStreamVarint(this->file, size)) break;
+
+		std::uint64_t offset = this->file.tellg();
+		if (offset + size > fileSize) break;
+
+		if (type == static_cast<int>(ReplayRecord::Keyframe))
+			this->keyframes.push_back(static_cast<int>(this->offsets.size()));
+		this->offsets.push_back(offset);
+		this->sizes.push_back(static_cast<std::uint32_t>(size));
+		this->types.push_back(static_cast<ReplayRecord>(type));
+		this->file.seekg(size, std::ios::cur);
+	}
+	this->file.clear();
+
+	if (this->keyframes.empty() || this->keyframes.front() != 0) return false;
+
+	this->cells.assign(static_cast<std::size_t>(this->width) * this->height, 0);
+	return this->seek(0);
+}
+
+bool ReplayPlayer::seek(int tick)
+{
+	/*
+		@return bool - false if a record could not be decoded
+
+		Rebuilds the cells of a tick. Moving forward within the same keyframe span
+		applies only the deltas after the current tick.
+	*/
+
+	if (this->offsets.empty()) return false;
+	tick = std::clamp(tick, 0, this->getTickCount() - 1);
+
+	int keyframe = *(std::upper_bound(this->keyframes.begin(), this->keyframes.end(), tick) - 1);
+	int from = (this->tick >= keyframe && this->tick <= tick) ? this->tick + 1 : keyframe;
+
+	for (int t = from; t <= tick; t++) {
+		if (!this->applyRecord(t)) return false;
+		this->tick = t;
+	}
+	return true;
+}
+
+bool ReplayPlayer::advance(int ticks)
+{
+	return this->seek(this->tick + ticks);
+}
+
+// === Private ===
+bool ReplayPlayer::applyRecord(int tick)
+{
+	this->payload.resize(this->sizes[tick]);
+	this->file.seekg(this->offsets[tick]);
+	if (!this->file.read(reinterpret_cast<char*>(this->payload.data()), this->payload.size()))
+		return false;
+
+	if (this->types[tick] == ReplayRecord::Keyframe)
+		return decodeKeyframe(this->payload, this->palette, this->cells);
+	return decodeDelta(this->payload, this->palette, this->cells);
+}
@@ -0,0 +1,98 @@
+#include "ReplayRecorder.h"
+
+// STL
+#include <algorithm>
+
+// === Constructors ===
+ReplayRecorder::ReplayRecorder() { }
+
+ReplayRecorder::~ReplayRecorder()
+{
+	this->close();
+}
+
+// === Accessors ===
+bool ReplayRecorder::isRecording() const
+{
+	return this->file.is_open();
+}
+
+const std::string& ReplayRecorder::getPath() const
+{
+	return this->path;
+}
+
+int ReplayRecorder::getTickCount() const
+{
+	return this->ticks;
+}
+
+std::uint64_t ReplayRecorder::getByteCount() const
+{
+	return this->bytes;
+}
+
+// === Methods ===
+bool ReplayRecorder::open(const std::string& path, int width, int height, int keyframeInterval)
+{
+	this->close();
+
+	this->file.open(path, std::ios::binary | std::ios::trunc);
+	if (!this->file.is_open()) return false;
+
+	this->path = path;
+	this->keyframeInterval = std::max(keyframeInterval, 1);
+	this->ticks = 0;
+	this->previous.assign(static_cast<std::size_t>(width) * height, 0);
+
+	this->header.assign(REPLAY_MAGIC, REPLAY_MAGIC + sizeof(REPLAY_MAGIC));
+	this->header.push_back(REPLAY_VERSION);
+	writeVarint(this->header, width);
+	writeVarint(this->header, height);
+	this->file.write(reinterpret_cast<const char*>(this->header.data()), this->header.size());
+	this->bytes = this->header.size();
+
+	return true;
+}
+
+void ReplayRecorder::record(const std::vector<std::uint32_t>& cells)
+{
+	/*
+		@return void
+
+		Appends one tick. Only cells that changed since the last tick are written,
+		except on keyframe ticks.
+	*/
+
+	if (!this->isRecording() || cells.size() != this->previous.size()) return;
+
+	if (this->ticks % this->keyframeInterval == 0) {
+		encodeKeyframe(cells, this->palette, this->payload);
+		this->writeRecord(ReplayRecord::Keyframe);
+	}
+	else {
+		encodeDelta(this->previous, cells, this->palette, this->payload);
+		this->writeRecord(ReplayRecord::Delta);
+	}
+
+	this->previous = cells;
+	this->ticks++;
+}
+
+void ReplayRecorder::close()
+{
+	if (this->file.is_open())
+		this->file.close();
+}
+
+// === Private ===
+void ReplayRecorder::writeRecord(ReplayRecord type)
+{
+	this->header.clear();
+	this->header.push_back(static_cast<std::uint8_t>(type));
+	writeVarint(this->header, this->payload.size());
+
+	this->file.write(reinterpret_cast<const char*>(this->header.data()), this->header.size());
+	this->file.write(reinterpret_cast<const char*>(this->payload.data()), this->payload.size());
+	this->bytes += this->header.size() + this->payload.size();
+}
@@ -0,0 +1,279 @@
+#include "RewindBuffer.h"
+
+// Project headers
+#include "Tracer.h"
+
+// STL
+#include <algorithm>
+
+// === Constructors ===
+RewindBuffer::RewindBuffer(int windowTicks, std::size_t memoryLimit)
+	: windowTicks(std::max(windowTicks, 1)),
+	memoryLimit(memoryLimit),
+	encoder(2, "Rewind encoder") // the pool keeps one thread for its caller
+{ }
+
+RewindBuffer::~RewindBuffer()
+{
+	this->flush();
+}
+
+// === Accessors ===
+int RewindBuffer::getFirstTick() const
+{
+	std::lock_guard<std::mutex> lock(this->mutex);
+	return this->segments.empty() ? this->lastTick : this->segments.front().firstTick;
+}
+
+int RewindBuffer::getLastTick() const
+{
+	return this->lastTick;
+}
+
+std::size_t RewindBuffer::getByteCount() const
+{
+	std::lock_guard<std::mutex> lock(this->mutex);
+	return this->bytes;
+}
+
+// === Grid sync ===
+void RewindBuffer::resize(int width, int height)
+{
+	/*
+		@return void
+
+		Starts an empty timeline for a grid of width x height cells, every chunk is captured with the next tick
+	*/
+
+	this->clear();
+
+	this->width = width;
+	this->height = height;
+	int chunkCount = ((width + REWIND_CHUNK_SIZE - 1) >> REWIND_CHUNK_SHIFT) * ((height + REWIND_CHUNK_SIZE - 1) >> REWIND_CHUNK_SHIFT);
+	this->pending.assign(chunkCount, 1);
+	this->pendingChunks.resize(chunkCount);
+	for (int chunk = 0; chunk < chunkCount; chunk++)
+		this->pendingChunks[chunk] = chunk;
+}
+
+void RewindBuffer::markChanged(const std::vector<int>& chunks)
+{
+	for (int chunk : chunks) {
+		if (!this->pending[chunk]) {
+			this->pending[chunk] = 1;
+			this->pendingChunks.push_back(chunk);
+		}
+	}
+}
+
+// === Methods ===
+void RewindBuffer::clear()
+{
+	this->flush();
+
+	std::lock_guard<std::mutex> lock(this->mutex);
+	this->segments.clear();
+	this->bytes = 0;
+	this->startSegment = true;
+	this->lastTick = -1;
+}
+
+RewindFrame* RewindBuffer::acquire()
+{
+	/*
+		@return RewindFrame* - frame listing the pending chunks to pack, nullptr if the tick is dropped
+
+		Takes the pending chunks into a free frame. When the encoder is
+		REWIND_QUEUE_LIMIT frames behind the tick is dropped instead of waiting,
+		its chunks stay pending and go out with the next captured tick.
+	*/
+
+	RewindFrame* frame;
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+
+		if (this->freeBuffers.empty() && this->buffers.size() < REWIND_QUEUE_LIMIT) {
+			this->buffers.push_back(std::make_unique<RewindFrame>());
+			this->freeBuffers.push_back(this->buffers.back().get());
+		}
+		if (this->freeBuffers.empty())
+			return nullptr;
+
+		frame = this->freeBuffers.back();
+		this->freeBuffers.pop_back();
+		this->inFlight++;
+	}
+
+	frame->width = this->width;
+	frame->height = this->height;
+	frame->chunks.swap(this->pendingChunks);
+	this->pendingChunks.clear();
+	for (int chunk : frame->chunks)
+		this->pending[chunk] = 0;
+	return frame;
+}
+
+void RewindBuffer::submit(RewindFrame* frame)
+{
+	int tick = ++this->lastTick;
+	this->encoder.submit([this, frame, tick] {
+		this->encode(frame, tick);
+		});
+}
+
+bool RewindBuffer::restore(int tick, std::vector<std::uint32_t>& cells)
+{
+	/*
+		@return bool - false if the tick is no longer (or not yet) in the buffer
+
+		Decodes a tick from the keyframe of its segment and the deltas after it.
+	*/
+
+	this->flush();
+
+	std::lock_guard<std::mutex> lock(this->mutex);
+
+	auto segment = std::find_if(this->segments.rbegin(), this->segments.rend(),
+		[tick](const Segment& segment) { return segment.firstTick <= tick; });
+	if (segment == this->segments.rend() || tick - segment->firstTick >= static_cast<int>(segment->ends.size()))
+		return false;
+
+	ReplayPalette decodePalette;
+	cells.resize(this->current.size());
+
+	std::size_t begin = 0;
+	for (int t = 0; t <= tick - segment->firstTick; t++) {
+		std::size_t end = segment->ends[t];
+		this->decodePayload.assign(segment->data.begin() + begin, segment->data.begin() + end);
+		begin = end;
+
+		bool decoded = t == 0 ?
+			decodeKeyframe(this->decodePayload, decodePalette, cells) :
+			decodeDelta(this->decodePayload, decodePalette, cells);
+		if (!decoded) return false;
+	}
+	return true;
+}
+
+void RewindBuffer::truncate(int tick)
+{
+	/*
+		@return void
+
+		Drops every tick after the given one, so the simulation can resume from it.
+		The next submitted tick starts a new segment.
+	*/
+
+	this->flush();
+
+	std::lock_guard<std::mutex> lock(this->mutex);
+
+	while (!this->segments.empty() && this->segments.back().firstTick > tick) {
+		this->bytes -= this->segments.back().data.size();
+		this->segments.pop_back();
+	}
+
+	if (!this->segments.empty()) {
+		Segment& segment = this->segments.back();
+		std::size_t count = static_cast<std::size_t>(tick - segment.firstTick + 1);
+		if (count < segment.ends.size()) {
+			this->bytes -= segment.data.size() - segment.ends[count - 1];
+			segment.data.resize(segment.ends[count - 1]);
+			segment.ends.resize(count);
+		}
+	}
+
+	this->startSegment = true;
+	this->lastTick = std::min(this->lastTick, tick);
+}
+
+// === Private ===
+void RewindBuffer::flush()
+{
+	std::unique_lock<std::mutex> lock(this->mutex);
+	this->bufferReturned.wait(lock, [this] { return this->inFlight == 0; });
+}
+
+void RewindBuffer::encode(RewindFrame* frame, int tick)
+{
+	/*
+		@return void
+
+		Applies the frame's chunks to the encoder's copy of the grid and encodes the
+		result, as a delta against the tick before it or as a keyframe
+	*/
+
+	TRACE_SCOPE("Rewind encode");
+
+	std::size_t size = static_cast<std::size_t>(frame->width) * frame->height;
+
+	bool keyframe;
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		keyframe = this->startSegment || this->segments.empty() ||
+			tick - this->segments.back().firstTick >= REWIND_KEYFRAME_INTERVAL ||
+			size != this->current.size();
+		this->startSegment = false;
+	}
+
+	// A new grid size comes with every chunk pending, so the whole copy is rewritten
+	if (size != this->current.size())
+		this->current.assign(size, 0);
+	if (!keyframe)
+		this->previous = this->current;
+
+	int columns = (frame->width + REWIND_CHUNK_SIZE - 1) >> REWIND_CHUNK_SHIFT;
+	const std::uint32_t* source = frame->cells.data();
+	for (int chunk : frame->chunks) {
+		int left = (chunk % columns) << REWIND_CHUNK_SHIFT;
+		int top = (chunk / columns) << REWIND_CHUNK_SHIFT;
+		int right = std::min(left + REWIND_CHUNK_SIZE, frame->width);
+		int bottom = std::min(top + REWIND_CHUNK_SIZE, frame->height);
+
+		for (int y = top; y < bottom; y++) {
+			const std::uint32_t* row = source + (y - top) * REWIND_CHUNK_SIZE;
+			std::copy(row, row + (right - left), this->current.begin() + left + static_cast<std::size_t>(y) * frame->width);
+		}
+		source += REWIND_CHUNK_SIZE * REWIND_CHUNK_SIZE;
+	}
+
+	if (keyframe)
+		encodeKeyframe(this->current, this->palette, this->payload);
+	else
+		encodeDelta(this->previous, this->current, this->palette, this->payload);
+
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		if (keyframe)
+			this->segments.push_back({ tick, {}, {} });
+
+		Segment& segment = this->segments.back();
+		segment.data.insert(segment.data.end(), this->payload.begin(), this->payload.end());
+		segment.ends.push_back(segment.data.size());
+		this->bytes += this->payload.size();
+		this->trim();
+
+		this->freeBuffers.push_back(frame);
+		this->inFlight--;
+	}
+	this->bufferReturned.notify_all();
+}
+
+void RewindBuffer::trim()
+{
+	/*
+		@return void
+
+		Drops the oldest segment while the others still cover the window, or while
+		the buffer is over its memory limit. The newest segment is always kept.
+	*/
+
+	const Segment& newest = this->segments.back();
+	int newestTick = newest.firstTick + static_cast<int>(newest.ends.size()) - 1;
+
+	while (this->segments.size() > 1 &&
+		(newestTick - this->segments[1].firstTick + 1 >= this->windowTicks || this->bytes > this->memoryLimit)) {
+		this->bytes -= this->segments.front().data.size();
+		this->segments.pop_front();
+	}
+}
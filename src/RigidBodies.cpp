@@ -0,0 +1,507 @@
+#include "RigidBodies.h"
+
+// Project headers
+#include "Game.h"
+#include "Tracer.h"
+
+// STL
+#include <algorithm>
+#include <utility>
+
+// === Constructors ===
+RigidBodies::RigidBodies() { }
+
+// === Accessors ===
+bool RigidBodies::isRigid(MaterialType type)
+{
+	return type == MaterialType::Stone || type == MaterialType::Brick;
+}
+
+bool RigidBodies::isPassable(MaterialType type)
+{
+	/*
+		@return bool - true for cells a falling block moves through, they end up above it
+	*/
+
+	MaterialState state = static_cast<MaterialState>(static_cast<uint16_t>(type) & STATE_MASK);
+	return type == MaterialType::Empty || state == MaterialState::Liquid || state == MaterialState::Gaseous;
+}
+
+int RigidBodies::getComponent(int x, int y)
+{
+	int c = y * this->width + x;
+	return this->rigid[c] ? this->find(this->labels[c]) : -1;
+}
+
+std::size_t RigidBodies::getFallingCount() const
+{
+	return this->falling;
+}
+
+bool RigidBodies::isIdle() const
+{
+	return this->removed.empty() && this->unsettled.empty();
+}
+
+// === Grid sync ===
+void RigidBodies::resize(int width, int height)
+{
+	this->width = width;
+	this->height = height;
+
+	std::size_t size = static_cast<std::size_t>(width) * height;
+	this->rigid.assign(size, 0);
+	this->labels.assign(size, -1);
+	this->visits.assign(size, 0);
+	this->parents.clear();
+	this->rigidCount = 0;
+	this->removed.clear();
+	this->unsettled.clear();
+	this->falling = 0;
+}
+
+void RigidBodies::setMaterial(int x, int y, MaterialType previous, MaterialType material)
+{
+	if (this->moving) return;
+
+	int c = y * this->width + x;
+	bool now = isRigid(material);
+
+	if (this->rigid[c] && !now)
+		this->removeCell(c);
+	else if (!this->rigid[c] && now)
+		this->addCell(c);
+
+	if (!isPassable(previous) && isPassable(material))
+		this->markBelowChanged(x, y);
+}
+
+void RigidBodies::swapCells(int x1, int y1, int x2, int y2, MaterialType type1, MaterialType type2)
+{
+	/*
+		@return void
+
+		Swap hook, type1 and type2 are the materials after the swap. A cell that has
+		become passable may have been holding up a block.
+	*/
+
+	if (this->moving) return;
+
+	// The cell rules never move rigid cells, but treat it as two placements if one does
+	if (isRigid(type1) || isRigid(type2)) {
+		this->setMaterial(x1, y1, type2, type1);
+		this->setMaterial(x2, y2, type1, type2);
+		return;
+	}
+
+	if (isPassable(type1) && !isPassable(type2))
+		this->markBelowChanged(x1, y1);
+	if (isPassable(type2) && !isPassable(type1))
+		this->markBelowChanged(x2, y2);
+}
+
+void RigidBodies::shiftColumnDown(int x, int top)
+{
+	// A column shift leaves the passable cell from below at its top
+	if (this->moving) return;
+	this->markBelowChanged(x, top);
+}
+
+// === Main logic ===
+void RigidBodies::update(Game& game)
+{
+	/*
+		@return void
+
+		- split components around the cells removed since the last update
+		- check every unsettled component for support once
+		- move the unsupported ones down a cell, lowest first
+
+		Advances falling structures by one tick.
+	*/
+
+	TRACE_SCOPE("Falling structures");
+
+	this->splitRemoved();
+
+	// Ids of merged and split components are never reused, relabel once they outnumber the cells
+	if (this->parents.size() > RIGID_COMPACT_FACTOR * this->rigidCount + RIGID_COMPACT_MINIMUM)
+		this->compact();
+
+	this->falling = 0;
+	if (this->unsettled.empty()) return;
+
+	std::vector<std::pair<int, int>> candidates;
+	for (int c : this->unsettled)
+		if (this->rigid[c])
+			candidates.push_back({ this->find(this->labels[c]), c });
+	this->unsettled.clear();
+
+	std::sort(candidates.begin(), candidates.end());
+	candidates.erase(std::unique(candidates.begin(), candidates.end(),
+		[](const auto& a, const auto& b) { return a.first == b.first; }), candidates.end());
+
+	std::vector<std::vector<int>> bodies;
+	for (const auto& candidate : candidates)
+		if (!this->collect(game, candidate.second, this->cells))
+			bodies.push_back(this->cells);
+
+	// Lower blocks move first, so a block never moves into one that has not moved yet
+	std::sort(bodies.begin(), bodies.end(), [](const std::vector<int>& a, const std::vector<int>& b) {
+		return *std::max_element(a.begin(), a.end()) > *std::max_element(b.begin(), b.end());
+		});
+
+	this->falling = bodies.size();
+	for (std::vector<int>& body : bodies)
+		this->moveDown(game, body);
+}
+
+// === Private ===
+int RigidBodies::find(int id)
+{
+	while (this->parents[id] != id) {
+		this->parents[id] = this->parents[this->parents[id]];
+		id = this->parents[id];
+	}
+	return id;
+}
+
+int RigidBodies::unite(int a, int b)
+{
+	a = this->find(a);
+	b = this->find(b);
+	if (a != b)
+		this->parents[std::max(a, b)] = std::min(a, b);
+	return std::min(a, b);
+}
+
+int RigidBodies::newComponent()
+{
+	this->parents.push_back(static_cast<int>(this->parents.size()));
+	return this->parents.back();
+}
+
+void RigidBodies::compact()
+{
+	/*
+		@return void
+
+		Gives the live components the ids 0..n - 1 and drops the rest of the forest
+	*/
+
+	std::vector<int> ids(this->parents.size(), -1);
+	int next = 0;
+	for (std::size_t c = 0; c < this->rigid.size(); c++) {
+		if (!this->rigid[c]) continue;
+
+		int root = this->find(this->labels[c]);
+		if (ids[root] < 0)
+			ids[root] = next++;
+		this->labels[c] = ids[root];
+	}
+
+	this->parents.resize(next);
+	for (int id = 0; id < next; id++)
+		this->parents[id] = id;
+}
+
+void RigidBodies::addCell(int c)
+{
+	/*
+		@return void
+
+		Joins a new rigid cell to the components next to it. Only an isolated cell
+		takes a new component id.
+	*/
+
+	int x = c % this->width;
+	int y = c / this->width;
+	int neighbors[4] = {
+		x > 0 ? c - 1 : -1,
+		x + 1 < this->width ? c + 1 : -1,
+		y > 0 ? c - this->width : -1,
+		y + 1 < this->height ? c + this->width : -1
+	};
+
+	int root = -1;
+	for (int n : neighbors) {
+		if (n < 0 || !this->rigid[n]) continue;
+		root = root < 0 ? this->find(this->labels[n]) : this->unite(root, this->labels[n]);
+	}
+
+	this->rigid[c] = 1;
+	this->rigidCount++;
+	this->labels[c] = root < 0 ? this->newComponent() : root;
+	this->unsettled.push_back(c);
+}
+
+void RigidBodies::removeCell(int c)
+{
+	// Splits are resolved in update, after every removal of the tick is known
+	this->rigid[c] = 0;
+	this->rigidCount--;
+	this->removed.push_back(c);
+}
+
+void RigidBodies::markBelowChanged(int x, int y)
+{
+	if (y > 0 && this->rigid[(y - 1) * this->width + x])
+		this->unsettled.push_back((y - 1) * this->width + x);
+}
+
+void RigidBodies::splitRemoved()
+{
+	/*
+		@return void
+
+		Finds out whether the cells removed since the last update broke components
+		apart. Removals are handled together, since a structure cut by a brush stroke
+		only comes apart over several removed cells. Every piece next to a removed cell
+		is rechecked for support.
+	*/
+
+	std::vector<std::pair<int, int>> starts;  // (component, cell) next to a removed cell
+	for (int c : this->removed) {
+		if (this->rigid[c]) continue;
+
+		int x = c % this->width;
+		int y = c / this->width;
+		int neighbors[4] = {
+			x > 0 ? c - 1 : -1,
+			x + 1 < this->width ? c + 1 : -1,
+			y > 0 ? c - this->width : -1,
+			y + 1 < this->height ? c + this->width : -1
+		};
+
+		for (int n : neighbors) {
+			if (n < 0 || !this->rigid[n]) continue;
+			starts.push_back({ this->find(this->labels[n]), n });
+			this->unsettled.push_back(n);
+		}
+	}
+	this->removed.clear();
+
+	std::sort(starts.begin(), starts.end());
+	starts.erase(std::unique(starts.begin(), starts.end()), starts.end());
+
+	// Cells of different components are apart already
+	std::vector<int> group;
+	for (std::size_t i = 0; i < starts.size();) {
+		std::size_t j = i;
+		group.clear();
+		while (j < starts.size() && starts[j].first == starts[i].first)
+			group.push_back(starts[j++].second);
+
+		if (group.size() > 1)
+			this->separate(group, starts[i].first);
+		i = j;
+	}
+}
+
+void RigidBodies::separate(const std::vector<int>& starts, int root)
+{
+	/*
+		@return void
+
+		Runs one search per start cell, a step each in turn. Searches that meet are
+		merged into a group. A group whose searches all run out of cells while another
+		is still going is a piece that broke off and gets a new component id; the last
+		group keeps the old one. The cost follows the smaller pieces, not the whole
+		component.
+	*/
+
+	int count = static_cast<int>(starts.size());
+	int base = this->stamp + 1;
+	this->stamp += count;
+
+	std::vector<std::vector<int>> frontiers(count);
+	std::vector<std::vector<int>> found(count);
+	std::vector<std::vector<int>> members(count);  // searches of each group
+	std::vector<int> groups(count);
+	std::vector<int> active(count, 1);             // searches of each group that still have cells
+
+	for (int k = 0; k < count; k++) {
+		frontiers[k].push_back(starts[k]);
+		found[k].push_back(starts[k]);
+		members[k].push_back(k);
+		groups[k] = k;
+		this->visits[starts[k]] = base + k;
+	}
+
+	auto groupOf = [&](int k) {
+		while (groups[k] != k)
+			k = groups[k] = groups[groups[k]];
+		return k;
+		};
+
+	int open = count;
+	while (open > 1) {
+		for (int k = 0; k < count && open > 1; k++) {
+			if (frontiers[k].empty()) continue;
+
+			int c = frontiers[k].back();
+			frontiers[k].pop_back();
+
+			int x = c % this->width;
+			int y = c / this->width;
+			int neighbors[4] = {
+				x > 0 ? c - 1 : -1,
+				x + 1 < this->width ? c + 1 : -1,
+				y > 0 ? c - this->width : -1,
+				y + 1 < this->height ? c + this->width : -1
+			};
+
+			for (int n : neighbors) {
+				if (n < 0 || !this->rigid[n] || this->find(this->labels[n]) != root) continue;
+
+				int owner = this->visits[n] - base;
+				if (owner >= 0 && owner < count) {
+					int a = groupOf(k);
+					int b = groupOf(owner);
+					if (a != b) {
+						if (a > b) std::swap(a, b);
+						groups[b] = a;
+						active[a] += active[b];
+						members[a].insert(members[a].end(), members[b].begin(), members[b].end());
+						open--;
+					}
+					continue;
+				}
+
+				this->visits[n] = base + k;
+				frontiers[k].push_back(n);
+				found[k].push_back(n);
+			}
+
+			if (!frontiers[k].empty()) continue;
+
+			// The group ran out of cells while others are still searching, it broke off
+			int g = groupOf(k);
+			if (--active[g] > 0 || open <= 1) continue;
+
+			int id = this->newComponent();
+			for (int member : members[g])
+				for (int cell : found[member])
+					this->labels[cell] = id;
+			open--;
+		}
+	}
+}
+
+bool RigidBodies::collect(Game& game, int c, std::vector<int>& cells)
+{
+	/*
+		@return bool - true if something holds the component up
+
+		Walks the component of a cell, trying the cell below first so a supported
+		component usually finds its support within a few steps. Without support,
+		cells ends up holding the whole component.
+	*/
+
+	int root = this->find(this->labels[c]);
+	this->stamp++;
+
+	cells.clear();
+	this->stack.clear();
+	this->stack.push_back(c);
+	this->visits[c] = this->stamp;
+
+	while (!this->stack.empty()) {
+		int p = this->stack.back();
+		this->stack.pop_back();
+		cells.push_back(p);
+
+		int x = p % this->width;
+		int y = p / this->width;
+
+		if (y + 1 >= this->height) return true;
+
+		int below = p + this->width;
+		bool belowInside = this->rigid[below] && this->find(this->labels[below]) == root;
+		if (!belowInside && !isPassable(game.getMaterialType(x, y + 1))) return true;
+
+		// Pushed last so it is taken first
+		int neighbors[4] = {
+			y > 0 ? p - this->width : -1,
+			x > 0 ? p - 1 : -1,
+			x + 1 < this->width ? p + 1 : -1,
+			belowInside ? below : -1
+		};
+
+		for (int n : neighbors) {
+			if (n < 0 || this->visits[n] == this->stamp || !this->rigid[n] || this->find(this->labels[n]) != root)
+				continue;
+			this->visits[n] = this->stamp;
+			this->stack.push_back(n);
+		}
+	}
+
+	return false;
+}
+
+void RigidBodies::moveDown(Game& game, std::vector<int>& body)
+{
+	/*
+		@return void
+
+		Moves a component one cell down. Every vertical run of its cells is shifted
+		over the passable cell below it, which ends up on top of the run. A component
+		that comes to rest joins the components it touches.
+	*/
+
+	int id = this->find(this->labels[body.front()]);
+
+	// Column by column, top to bottom
+	std::sort(body.begin(), body.end(), [this](int a, int b) {
+		int ax = a % this->width;
+		int bx = b % this->width;
+		return ax != bx ? ax < bx : a < b;
+		});
+
+	std::vector<std::pair<int, int>> tops;  // (x, y) of the cell each run leaves behind
+	this->moving = true;
+	for (std::size_t i = 0; i < body.size();) {
+		std::size_t j = i;
+		while (j + 1 < body.size() && body[j + 1] == body[j] + this->width)
+			j++;
+
+		int x = body[i] % this->width;
+		int top = body[i] / this->width;
+		game.shiftColumnDown(x, top, body[j] / this->width);
+		tops.push_back({ x, top });
+		i = j + 1;
+	}
+	this->moving = false;
+
+	for (int c : body)
+		this->rigid[c] = 0;
+	for (int& c : body) {
+		c += this->width;
+		this->rigid[c] = 1;
+		this->labels[c] = id;
+	}
+
+	for (const auto& [x, top] : tops)
+		this->markBelowChanged(x, top);
+
+	if (!this->collect(game, body.front(), this->cells)) {
+		this->unsettled.push_back(body.front());
+		return;
+	}
+
+	// Landed, weld it to whatever it touches
+	for (int c : body) {
+		int x = c % this->width;
+		int y = c / this->width;
+		int neighbors[4] = {
+			x > 0 ? c - 1 : -1,
+			x + 1 < this->width ? c + 1 : -1,
+			y > 0 ? c - this->width : -1,
+			y + 1 < this->height ? c + this->width : -1
+		};
+
+		for (int n : neighbors)
+			if (n >= 0 && this->rigid[n])
+				id = this->unite(id, this->labels[n]);
+	}
+}
@@ -0,0 +1,124 @@
+#include "ThreadPool.h"
+
+// Project headers
+#include "Tracer.h"
+
+// STL
+#include <algorithm>
+
+// === Constructors ===
+ThreadPool::ThreadPool(unsigned threadCount, const std::string& name)
+{
+	// The calling thread takes a share of every parallelFor, so keep one core for it
+	unsigned workerCount = threadCount > 1 ? threadCount - 1 : 0;
+
+	for (unsigned i = 0; i < workerCount; i++)
+		this->workers.emplace_back(&ThreadPool::workerLoop, this, name + " " + std::to_string(i + 1));
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		this->stopping = true;
+	}
+	this->taskAvailable.notify_all();
+
+	for (std::thread& worker : this->workers)
+		worker.join();
+}
+
+// === Accessors ===
+unsigned ThreadPool::getThreadCount() const
+{
+	return static_cast<unsigned>(this->workers.size()) + 1;
+}
+
+// === Methods ===
+void ThreadPool::submit(std::function<void()> task)
+{
+	/*
+		@return void
+
+		Queues a task for the workers. Runs it in place when the pool has no workers.
+	*/
+
+	if (this->workers.empty()) {
+		task();
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		this->tasks.push(std::move(task));
+	}
+	this->taskAvailable.notify_one();
+}
+
+void ThreadPool::parallelFor(int begin, int end, const std::function<void(int, int)>& body, int grain)
+{
+	/*
+		@return void
+
+		Splits [begin, end) into contiguous ranges of at least grain items, one per thread,
+		and blocks until every range has been processed.
+	*/
+
+	int count = end - begin;
+	if (count <= 0) return;
+
+	int chunks = std::min(count / std::max(grain, 1), static_cast<int>(this->getThreadCount()));
+	if (chunks <= 1) {
+		body(begin, end);
+		return;
+	}
+
+	int step = (count + chunks - 1) / chunks;
+
+	std::mutex doneMutex;
+	std::condition_variable doneCondition;
+	int remaining = chunks - 1;
+
+	for (int i = 1; i < chunks; i++) {
+		int from = begin + i * step;
+		int to = std::min(end, from + step);
+
+		this->submit([&, from, to]() {
+			if (from < to)
+				body(from, to);
+
+			std::lock_guard<std::mutex> lock(doneMutex);
+			if (--remaining == 0)
+				doneCondition.notify_one();
+			});
+	}
+
+	body(begin, std::min(end, begin + step));
+
+	std::unique_lock<std::mutex> lock(doneMutex);
+	doneCondition.wait(lock, [&]() { return remaining == 0; });
+}
+
+void ThreadPool::workerLoop(std::string name)
+{
+	// Names the thread in timeline traces
+	Tracer::setThreadName(name);
+
+	while (true) {
+		std::function<void()> task;
+
+		{
+			std::unique_lock<std::mutex> lock(this->mutex);
+			this->taskAvailable.wait(lock, [this]() { return this->stopping || !this->tasks.empty(); });
+
+			if (this->stopping && this->tasks.empty())
+				return;
+
+			task = std::move(this->tasks.front());
+			this->tasks.pop();
+		}
+
+		TRACE_SCOPE("Task");
+		task();
+	}
+}
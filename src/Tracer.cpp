@@ -0,0 +1,169 @@
+#include "Tracer.h"
+
+// STL
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace {
+	// Fields are atomic so a dump can read a buffer while its thread keeps writing
+	struct TraceEvent {
+		std::atomic<const char*> name{ nullptr };
+		std::atomic<std::int64_t> start{ 0 };
+		std::atomic<std::int64_t> end{ 0 };
+	};
+
+	struct ThreadBuffer {
+		std::unique_ptr<TraceEvent[]> events = std::make_unique<TraceEvent[]>(TRACE_BUFFER_EVENTS);
+		std::atomic<std::uint64_t> written{ 0 };
+		int threadId = 0;
+		std::string threadName;
+	};
+
+	// Buffers are kept after their thread ends, so its zones still make it into the dump
+	std::mutex registryMutex;
+	std::vector<std::unique_ptr<ThreadBuffer>> registry;
+	std::atomic<std::int64_t> traceStart{ 0 };
+
+	thread_local ThreadBuffer* threadBuffer = nullptr;
+	thread_local std::string threadName;
+
+	ThreadBuffer* getThreadBuffer()
+	{
+		if (threadBuffer) return threadBuffer;
+
+		std::lock_guard<std::mutex> lock(registryMutex);
+		registry.push_back(std::make_unique<ThreadBuffer>());
+		threadBuffer = registry.back().get();
+		threadBuffer->threadId = static_cast<int>(registry.size());
+		threadBuffer->threadName = threadName.empty() ? "Thread " + std::to_string(registry.size()) : threadName;
+		return threadBuffer;
+	}
+
+	void writeEscaped(std::ofstream& file, const char* text)
+	{
+		for (; *text; text++) {
+			if (*text == '"' || *text == '\\') file << '\\';
+			file << *text;
+		}
+	}
+}
+
+// === Methods ===
+void Tracer::start()
+{
+	/*
+		@return void
+
+		Starts a new trace. Zones recorded before it are left out of the next dump.
+	*/
+
+	traceStart.store(now(), std::memory_order_relaxed);
+	enabled.store(true, std::memory_order_relaxed);
+}
+
+void Tracer::stop()
+{
+	enabled.store(false, std::memory_order_relaxed);
+}
+
+void Tracer::setThreadName(const std::string& name)
+{
+	/*
+		@return void
+
+		Names the calling thread in the timeline. Costs nothing until the thread records a zone.
+	*/
+
+	threadName = name;
+	if (threadBuffer) {
+		std::lock_guard<std::mutex> lock(registryMutex);
+		threadBuffer->threadName = name;
+	}
+}
+
+bool Tracer::write(const std::string& path)
+{
+	/*
+		@return bool - false if the file could not be written
+
+		Writes the zones of every thread since the trace started, as complete ("X")
+		events in microseconds. Threads may keep tracing while this runs: a slot that
+		was overwritten during the copy is detected by the write counter and skipped.
+	*/
+
+	std::ofstream file(path);
+	if (!file) return false;
+
+	std::int64_t since = traceStart.load(std::memory_order_relaxed);
+
+	file << "{\"traceEvents\":[\n";
+	file << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"SimpleBox\"}}";
+
+	std::lock_guard<std::mutex> lock(registryMutex);
+	for (const std::unique_ptr<ThreadBuffer>& buffer : registry) {
+		file << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->threadId << ",\"args\":{\"name\":\"";
+		writeEscaped(file, buffer->threadName.c_str());
+		file << "\"}}";
+
+		std::uint64_t written = buffer->written.load(std::memory_order_acquire);
+		// The oldest slot may already be taken by the next zone
+		std::uint64_t first = written >= TRACE_BUFFER_EVENTS ? written - TRACE_BUFFER_EVENTS + 1 : 0;
+
+		for (std::uint64_t i = first; i < written; i++) {
+			const TraceEvent& event = buffer->events[i & (TRACE_BUFFER_EVENTS - 1)];
+			const char* name = event.name.load(std::memory_order_relaxed);
+			std::int64_t start = event.start.load(std::memory_order_relaxed);
+			std::int64_t end = event.end.load(std::memory_order_relaxed);
+
+			// The thread may have wrapped around onto this slot while it was read
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if (buffer->written.load(std::memory_order_relaxed) - i >= TRACE_BUFFER_EVENTS) continue;
+			if (!name || start < since) continue;
+
+			file << ",\n{\"name\":\"";
+			writeEscaped(file, name);
+			file << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->threadId
+				<< ",\"ts\":" << (start - since) / 1000.0 << ",\"dur\":" << (end - start) / 1000.0 << "}";
+		}
+	}
+
+	file << "\n]}\n";
+	return static_cast<bool>(file);
+}
+
+// === Recording ===
+void Tracer::record(const char* name, std::int64_t start, std::int64_t end)
+{
+	/*
+		@return void
+
+		Appends a zone to the ring of the calling thread. Only this thread writes the
+		ring, so publishing the slot is a single release store of the counter. The
+		fence before the slot is filled lets a reader that sees the new values also
+		see the counter that marks the slot as being overwritten.
+	*/
+
+	ThreadBuffer* buffer = getThreadBuffer();
+	std::uint64_t index = buffer->written.load(std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	TraceEvent& event = buffer->events[index & (TRACE_BUFFER_EVENTS - 1)];
+	event.name.store(name, std::memory_order_relaxed);
+	event.start.store(start, std::memory_order_relaxed);
+	event.end.store(end, std::memory_order_relaxed);
+
+	buffer->written.store(index + 1, std::memory_order_release);
+}
+
+std::int64_t Tracer::now()
+{
+	/*
+		@return std::int64_t - steady clock time in nanoseconds
+	*/
+
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+}
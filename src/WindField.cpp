@@ -0,0 +1,225 @@
+#include "WindField.h"
+
+// Project headers
+#include "Tracer.h"
+
+// STL
+#include <algorithm>
+#include <cmath>
+
+namespace {
+	const float WIND_DT = static_cast<float>(WIND_UPDATE_INTERVAL);
+	const float MAX_WIND_SPEED = 1.5f;    // grid cells per tick
+	const float WIND_DAMPING = 0.96f;     // velocity kept per wind tick
+	const float BUOYANCY = 0.0002f;       // upward acceleration per degree above ambient
+	const float VENT_FORCE = 0.04f;       // upward acceleration per vent cell in a sample
+	const int PRESSURE_ITERATIONS = 20;
+	const int ROW_GRAIN = 8;              // coarse rows per thread, smaller fields run inline
+}
+
+// === Constructors ===
+WindField::WindField() { }
+
+// === Accessors ===
+sf::Vector2f WindField::getVelocity(int x, int y) const
+{
+	/*
+		@return sf::Vector2f - velocity in grid cells per tick
+
+		Bilinear sample of the coarse field at a grid cell
+	*/
+
+	// Sample centres sit in the middle of their block, +1 skips the halo
+	float fx = std::clamp((x + 0.5f) / WIND_CELL_SIZE + 0.5f, 1.0f, static_cast<float>(this->width));
+	float fy = std::clamp((y + 0.5f) / WIND_CELL_SIZE + 0.5f, 1.0f, static_cast<float>(this->height));
+
+	int i = static_cast<int>(fx);
+	int j = static_cast<int>(fy);
+	float sx = fx - i;
+	float sy = fy - j;
+
+	int a = this->index(i, j);
+	int b = a + 1;
+	int c = a + this->stride;
+	int d = c + 1;
+
+	float wa = (1.0f - sx) * (1.0f - sy);
+	float wb = sx * (1.0f - sy);
+	float wc = (1.0f - sx) * sy;
+	float wd = sx * sy;
+
+	return {
+		this->u[a] * wa + this->u[b] * wb + this->u[c] * wc + this->u[d] * wd,
+		this->v[a] * wa + this->v[b] * wb + this->v[c] * wc + this->v[d] * wd
+	};
+}
+
+// === Grid sync ===
+void WindField::resize(int gridWidth, int gridHeight)
+{
+	this->gridWidth = gridWidth;
+	this->gridHeight = gridHeight;
+	this->width = (gridWidth + WIND_CELL_SIZE - 1) / WIND_CELL_SIZE;
+	this->height = (gridHeight + WIND_CELL_SIZE - 1) / WIND_CELL_SIZE;
+	this->stride = this->width + 2;
+
+	// The halo stays at zero: no flow through the walls, open pressure boundary
+	std::size_t size = static_cast<std::size_t>(this->stride) * (this->height + 2);
+	this->u.assign(size, 0.0f);
+	this->v.assign(size, 0.0f);
+	this->previousU.assign(size, 0.0f);
+	this->previousV.assign(size, 0.0f);
+	this->pressure.assign(size, 0.0f);
+	this->nextPressure.assign(size, 0.0f);
+	this->divergence.assign(size, 0.0f);
+	this->vents.assign(size, 0);
+}
+
+void WindField::replaceMaterial(int x, int y, MaterialType previous, MaterialType material)
+{
+	int i = this->index(x / WIND_CELL_SIZE + 1, y / WIND_CELL_SIZE + 1);
+
+	if (previous == MaterialType::Vent)
+		this->vents[i]--;
+	if (material == MaterialType::Vent)
+		this->vents[i]++;
+}
+
+// === Main logic ===
+void WindField::step(ThreadPool& pool, const HeatField& heat)
+{
+	/*
+		@return void
+
+		- add vent and buoyancy forces
+		- project, advect, project
+
+		Advances the velocity field by one wind tick.
+	*/
+
+	TRACE_SCOPE("Wind");
+
+	this->addForces(pool, heat);
+	this->project(pool);
+	this->advect(pool);
+	this->project(pool);
+}
+
+// === Private ===
+int WindField::index(int i, int j) const
+{
+	return j * this->stride + i;
+}
+
+void WindField::addForces(ThreadPool& pool, const HeatField& heat)
+{
+	pool.parallelFor(1, this->height + 1, [this, &heat](int from, int to) {
+		for (int j = from; j < to; j++) {
+			// Temperature is sampled once per block, at its centre
+			int cy = std::min((j - 1) * WIND_CELL_SIZE + WIND_CELL_SIZE / 2, this->gridHeight - 1);
+
+			for (int i = 1; i <= this->width; i++) {
+				int c = this->index(i, j);
+				int cx = std::min((i - 1) * WIND_CELL_SIZE + WIND_CELL_SIZE / 2, this->gridWidth - 1);
+
+				float lift = BUOYANCY * (heat.getTemperature(cx, cy) - AMBIENT_TEMPERATURE) + VENT_FORCE * this->vents[c];
+
+				this->u[c] = std::clamp(this->u[c] * WIND_DAMPING, -MAX_WIND_SPEED, MAX_WIND_SPEED);
+				this->v[c] = std::clamp(this->v[c] * WIND_DAMPING - WIND_DT * lift, -MAX_WIND_SPEED, MAX_WIND_SPEED);
+			}
+		}
+		}, ROW_GRAIN);
+}
+
+void WindField::advect(ThreadPool& pool)
+{
+	/*
+		@return void
+
+		Semi-Lagrangian advection: every sample traces its velocity back
+		and takes the bilinear value found there.
+	*/
+
+	this->previousU = this->u;
+	this->previousV = this->v;
+
+	const float scale = WIND_DT / WIND_CELL_SIZE;
+	const float maxX = this->width + 0.5f;
+	const float maxY = this->height + 0.5f;
+
+	pool.parallelFor(1, this->height + 1, [&](int from, int to) {
+		for (int j = from; j < to; j++) {
+			for (int i = 1; i <= this->width; i++) {
+				int c = this->index(i, j);
+
+				float x = std::clamp(i - scale * this->previousU[c], 0.5f, maxX);
+				float y = std::clamp(j - scale * this->previousV[c], 0.5f, maxY);
+
+				int i0 = static_cast<int>(x);
+				int j0 = static_cast<int>(y);
+				float sx = x - i0;
+				float sy = y - j0;
+
+				int a = this->index(i0, j0);
+				int b = a + 1;
+				int d = a + this->stride;
+				int e = d + 1;
+
+				this->u[c] = (1.0f - sy) * ((1.0f - sx) * this->previousU[a] + sx * this->previousU[b])
+					+ sy * ((1.0f - sx) * this->previousU[d] + sx * this->previousU[e]);
+				this->v[c] = (1.0f - sy) * ((1.0f - sx) * this->previousV[a] + sx * this->previousV[b])
+					+ sy * ((1.0f - sx) * this->previousV[d] + sx * this->previousV[e]);
+			}
+		}
+		}, ROW_GRAIN);
+}
+
+void WindField::project(ThreadPool& pool)
+{
+	/*
+		@return void
+
+		Removes the divergent part of the flow with a Jacobi pressure solve,
+		so the air swirls around instead of piling up.
+	*/
+
+	pool.parallelFor(1, this->height + 1, [this](int from, int to) {
+		for (int j = from; j < to; j++) {
+			int row = this->index(0, j);
+			for (int i = 1; i <= this->width; i++) {
+				int c = row + i;
+				this->divergence[c] = -0.5f * (this->u[c + 1] - this->u[c - 1] + this->v[c + this->stride] - this->v[c - this->stride]);
+				this->pressure[c] = 0.0f;
+			}
+		}
+		}, ROW_GRAIN);
+
+	for (int iteration = 0; iteration < PRESSURE_ITERATIONS; iteration++) {
+		pool.parallelFor(1, this->height + 1, [this](int from, int to) {
+			for (int j = from; j < to; j++) {
+				int row = this->index(0, j);
+				const float* p = &this->pressure[row];
+				const float* pUp = p - this->stride;
+				const float* pDown = p + this->stride;
+				const float* div = &this->divergence[row];
+				float* out = &this->nextPressure[row];
+
+				for (int i = 1; i <= this->width; i++)
+					out[i] = 0.25f * (div[i] + p[i - 1] + p[i + 1] + pUp[i] + pDown[i]);
+			}
+			}, ROW_GRAIN);
+
+		this->pressure.swap(this->nextPressure);
+	}
+
+	pool.parallelFor(1, this->height + 1, [this](int from, int to) {
+		for (int j = from; j < to; j++) {
+			int row = this->index(0, j);
+			for (int i = 1; i <= this->width; i++) {
+				int c = row + i;
+				this->u[c] -= 0.5f * (this->pressure[c + 1] - this->pressure[c - 1]);
+				this->v[c] -= 0.5f * (this->pressure[c + this->stride] - this->pressure[c - this->stride]);
+			}
+		}
+		}, ROW_GRAIN);
+}